@@ -13,6 +13,7 @@
 #include "json.hpp"
 #include <iostream>
 #include <fstream>
+#include <atomic>
 #ifdef QCS6490
 #include "adas.hpp"
 #endif
@@ -72,6 +73,17 @@ ADAS::ADAS(std::string configPath)
 	m_opticalFlow->runThread();
 	m_yoloADAS->runThread();
 	m_yoloADAS_PostProc->runThread();
+
+	// Enable display thread, fed by the render workers
+	if (m_dsp_results)
+	{
+		m_isDrawImage = true;
+		m_threadDrawImage = std::thread(&ADAS::_runDrawResultFunc, this);
+	}
+
+	// Enable render workers for drawing and saving debug images
+	if (ADAS_NUM_RENDER_WORKERS > 0 && (m_dsp_results || m_dbg_saveRawImages))
+		m_renderPool = new WorkerPool(ADAS_NUM_RENDER_WORKERS);
 };
 #endif
 
@@ -134,6 +146,12 @@ ADAS::~ADAS()
 	#endif
 	stopThread();
 
+	// Stage latency of the whole run
+	if (m_estimateTime)
+		showStageLatency();
+	if (m_dbg_saveLogs)
+		saveStageTrace(m_dbg_logsDirPath + "/stage_trace.json");
+
 	delete m_adasConfigReader;
 	delete m_config;
 	delete m_yoloADAS;
@@ -147,6 +165,13 @@ ADAS::~ADAS()
 	delete m_fcw;
 	delete m_OD_ROI;
 	delete m_roiBBox;
+	delete m_jsonLog;
+	delete m_frameArena;
+	delete m_framePool;
+	delete m_stageProfiler;
+	delete m_stageGraph;
+	delete m_workerPool;
+	delete m_renderPool;
 
 	m_adasConfigReader = nullptr;
 	m_config = nullptr;
@@ -161,6 +186,13 @@ ADAS::~ADAS()
 	m_fcw = nullptr;
 	m_OD_ROI = nullptr;
 	m_roiBBox = nullptr;
+	m_jsonLog = nullptr;
+	m_frameArena = nullptr;
+	m_framePool = nullptr;
+	m_stageProfiler = nullptr;
+	m_stageGraph = nullptr;
+	m_workerPool = nullptr;
+	m_renderPool = nullptr;
 };
 
 void ADAS::stopThread()
@@ -174,6 +206,30 @@ void ADAS::stopThread()
 
 	cout << "m_yoloADAS->stopThread()" << endl;
 	m_yoloADAS->stopThread();
+
+	// Finish queued renders first, they feed the display thread
+	if (m_renderPool != nullptr)
+	{
+		cout << "m_renderPool drain" << endl;
+		delete m_renderPool;
+		m_renderPool = nullptr;
+
+		cout << "render jobs: " << m_numRenderJobs << ", dropped: " << m_numDroppedRenders << endl;
+	}
+
+	if (m_threadDrawImage.joinable())
+	{
+		cout << "m_threadDrawImage.join()" << endl;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_threadTerminated = true;
+		}
+		m_condition.notify_all();
+		m_threadDrawImage.join();
+
+		cout << "dropped draw results: " << m_numDroppedDrawResults << endl;
+	}
+	m_isDrawImage = false;
 }
 
 #ifdef SAV837
@@ -349,16 +405,136 @@ bool ADAS::_init(std::string configPath)
 	m_humanTracker->setROI(m_roi);
 	cout << "[ADAS::_init] << Set up ROI for Tracker modules" << endl;
 
+	// One FCW data buffer for every tracker, in serial and parallel mode
 	std::vector<DataFrame>* fcwDataBufferPtr = m_fcw->getDataBuffer();
 	m_vehicleTracker->setDataBuffer(fcwDataBufferPtr);
 	m_riderTracker->setDataBuffer(fcwDataBufferPtr);
 	m_humanTracker->setDataBuffer(fcwDataBufferPtr);
+	m_parallelTracking = ADAS_PARALLEL_TRACKING;
 	cout << "[ADAS::_init] << Initialized Object Tracker modules" << endl;
 
 	_readDebugConfig();          // Debug Configuration
 	_readDisplayConfig();        // Display Configuration
 	_readShowProcTimeConfig();   // Show Processing Time Configuration
 
+	// Frame arena for per-frame scratch data
+	m_frameArena = new FrameArena(FRAME_ARENA_DEFAULT_SIZE);
+	m_detectionTable.setMemoryResource(m_frameArena);
+	m_rescaledDetectionTable.setMemoryResource(m_frameArena);
+	cout << "[ADAS::_init] << Initialized frame arena" << endl;
+
+	// Frame buffers: input frames, drawn results and mask copies
+	m_framePool = new FramePool(FRAME_POOL_DEFAULT_SIZE);
+	#ifdef QCS6490
+	m_framePool->reserve(m_config->modelHeight, m_config->modelWidth, CV_8UC3, 2);
+	if (m_dsp_results)
+	{
+		m_framePool->reserve(m_config->frameHeight, m_config->frameWidth, CV_8UC3, 2);
+		m_framePool->reserve(720, 1280, CV_8UC3, 2);
+	}
+	#endif
+	cout << "[ADAS::_init] << Initialized frame pool" << endl;
+
+	// Stage latency histograms and trace events
+	std::vector<std::string> stageNames(ADAS_NUM_STAGES);
+	stageNames[ADAS_STAGE_FRAME] = "Frame";
+	stageNames[ADAS_STAGE_EGO_DIRECTION] = "EgoDirection";
+	stageNames[ADAS_STAGE_LANE_LINE_MASKS] = "LaneLineMasks";
+	stageNames[ADAS_STAGE_LANE_LINE_DETECTION] = "LaneLineDetection";
+	stageNames[ADAS_STAGE_OBJECT_DETECTION] = "ObjectDetection";
+	stageNames[ADAS_STAGE_OBJECT_TRACKING] = "ObjectTracking";
+	stageNames[ADAS_STAGE_LANE_DEPARTURE] = "LaneDeparture";
+	stageNames[ADAS_STAGE_FORWARD_COLLISION] = "ForwardCollision";
+	stageNames[ADAS_STAGE_DRAW] = "Draw";
+	stageNames[ADAS_STAGE_SAVE_IMAGES] = "SaveImages";
+	stageNames[ADAS_STAGE_JSON_LOG] = "JsonLog";
+	m_stageProfiler = new StageProfiler(stageNames, STAGE_PROFILER_DEFAULT_TRACE_SIZE);
+	cout << "[ADAS::_init] << Initialized stage profiler" << endl;
+
+	_initJsonLog();              // JSON Log (needs debug log folder)
+	_initStageGraph();           // Per-frame processing stages
+
+	return ADAS_SUCCESS;
+}
+
+bool ADAS::_initJsonLog()
+{
+	JSON_LOG_Config_S jsonLogConfig;
+
+	// Verbosity follows the debug switches of the config file: frame records
+	// with ADAS debug on, every object too when object detection debug is on
+	jsonLogConfig.logLevel = JSON_LOG_LEVEL_INFO;
+	if (m_dbg_adas)
+		jsonLogConfig.logLevel = m_dbg_objectDetection ? JSON_LOG_LEVEL_TRACE : JSON_LOG_LEVEL_DEBUG;
+
+	jsonLogConfig.saveToFile = m_dbg_saveLogs;
+	jsonLogConfig.streamMode = true;
+	jsonLogConfig.flushPolicy = JSON_LOG_FLUSH_FRAME;
+	jsonLogConfig.flushInterval = 1;
+
+	// Serialize and write on a background thread, never stall the frame loop
+	jsonLogConfig.asyncWrite = m_dbg_saveLogs;
+	jsonLogConfig.queueCapacity = 64;
+	jsonLogConfig.queuePolicy = JSON_LOG_QUEUE_DROP_OLDEST;
+
+	// Black box: frames stay in memory, event windows are flushed at once
+	jsonLogConfig.blackBoxMode = ADAS_JSON_LOG_BLACK_BOX;
+	jsonLogConfig.blackBoxPreFrames = ADAS_BLACK_BOX_PRE_FRAMES;
+	jsonLogConfig.blackBoxPostFrames = ADAS_BLACK_BOX_POST_FRAMES;
+	if (jsonLogConfig.blackBoxMode)
+		jsonLogConfig.flushPolicy = JSON_LOG_FLUSH_NONE;
+
+	// Tracked objects as keyframes and per-track deltas (<log>.trk)
+	jsonLogConfig.saveTrackStream = ADAS_JSON_LOG_TRACK_STREAM;
+	jsonLogConfig.trackStreamOnly = ADAS_JSON_LOG_TRACK_STREAM;
+
+	// JSON Lines log lives next to the other debug logs of this run
+	std::string jsonLogPath = jsonLogConfig.blackBoxMode ? "blackbox.jsonl" : "output.jsonl";
+	if (m_dbg_saveLogs && m_dbg_logsDirPath != "")
+		jsonLogPath = m_dbg_logsDirPath + "/" + jsonLogPath;
+
+	m_jsonLog = new JSON_LOG(jsonLogPath, jsonLogConfig);
+	m_jsonLog->SetFrameMemoryResource(m_frameArena);
+	cout << "[ADAS::_init] << Initialized JSON log: " << jsonLogPath << endl;
+
+	return ADAS_SUCCESS;
+}
+
+bool ADAS::_initStageGraph()
+{
+	m_workerPool = new WorkerPool(ADAS_NUM_STAGE_WORKERS);
+	m_stageGraph = new StageGraph(m_workerPool);
+
+	// Lane line detection updates the FCW zones used by the box filters and
+	// vanishing line used by tracking, LDW reads the road signs: only LDW and
+	// tracking -> FCW are independent
+	int laneMasks = m_stageGraph->addStage("LaneLineMasks",
+		[this] { return _runStage(&ADAS::_getLaneLineMasks, "Get lane line mask failed ..."); });
+
+	int laneLines = m_stageGraph->addStage("LaneLineDetection",
+		[this] { return _runStage(&ADAS::_laneLineDetection, "Detect lane lines failed ..."); },
+		{laneMasks});
+
+	int objects = m_stageGraph->addStage("ObjectDetection",
+		[this] { return _runStage(&ADAS::_objectDetection, "Detect objects failed ..."); },
+		{laneLines});
+
+	int tracking = m_stageGraph->addStage("ObjectTracking",
+		[this] { return _runStage(&ADAS::_objectTracking, "Track objects failed ..."); },
+		{objects});
+
+	m_stageGraph->addStage("LaneDeparture",
+		[this] { return _runStage(&ADAS::_laneDepartureDetection, "Detect lane departure event failed ..."); },
+		{laneLines, objects});
+
+	m_stageGraph->addStage("ForwardCollision",
+		[this] { return _runStage(&ADAS::_forwardCollisionDetection, "Detect forward collision event failed ..."); },
+		{tracking});
+
+	cout << "[ADAS::_init] << Initialized stage graph with "
+		 << m_stageGraph->getNumStages() << " stages, "
+		 << m_workerPool->getNumThreads() << " worker threads" << endl;
+
 	return ADAS_SUCCESS;
 }
 
@@ -637,6 +813,7 @@ bool ADAS::_initROI()
 bool ADAS::run(cv::Mat &imgFrame)
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer frameTimer(m_stageProfiler, ADAS_STAGE_FRAME);
 	auto time_0 = std::chrono::high_resolution_clock::now();
 	auto time_1 = std::chrono::high_resolution_clock::now();
 
@@ -650,7 +827,7 @@ bool ADAS::run(cv::Mat &imgFrame)
 
 	// Get Image Frame
 	if (m_dsp_results)
-		m_dsp_img = imgFrame.clone();
+		m_dsp_img = m_framePool->clone(imgFrame);
 		
 	// Entry Point
 	if (m_frameIdx % m_frameStep == 0)
@@ -661,7 +838,7 @@ bool ADAS::run(cv::Mat &imgFrame)
 		m_logger->info("========================================");
 
 		// Get Image Frame
-		m_img = imgFrame.clone();
+		m_img = m_framePool->clone(imgFrame);
 
 		// Calculate Ego Direction Information
 		if (!_calcEgoDirection())
@@ -678,47 +855,12 @@ bool ADAS::run(cv::Mat &imgFrame)
 		exit(1);
 		}
 
-		// Get Lane Line Masks
-		if (!_getLaneLineMasks())
-		{
-		m_logger->warn("Get lane line mask failed ...");
-		ret = ADAS_FAILURE;
-		}
-
-		// Lane Line Detection
-		if (!_laneLineDetection())
-		{
-		m_logger->warn("Detect lane lines failed ...");
-		ret = ADAS_FAILURE;
-		}
-
-		// Get Detected Bounding Boxes
-		if (!_objectDetection())
-		{
-		m_logger->warn("Detect objects failed ...");
-		ret = ADAS_FAILURE;
-		}
-
-		// Object Tracking
-		if (!_objectTracking())
-		{
-		m_logger->warn("Track objects failed ...");
-		ret = ADAS_FAILURE;
-		}
-
-		// Detect Lane Departure Event
-		if (!_laneDepartureDetection())
-		{
-		m_logger->warn("Detect lane departure event failed ...");
-		ret = ADAS_FAILURE;
-		}
+		// Lane lines, objects, tracking, LDW and FCW (see _initStageGraph)
+		if (!m_stageGraph->run())
+			ret = ADAS_FAILURE;
 
-		// Forward Collision Warning
-		if (!_forwardCollisionDetection())
-		{
-		m_logger->warn("Detect forward collision event failed ...");
-		ret = ADAS_FAILURE;
-		}
+		// Rescale boxes to frame size once for drawing and logging
+		_rescaleResults();
 
 		// Show Results
 		_showDetectionResults();
@@ -737,16 +879,10 @@ bool ADAS::run(cv::Mat &imgFrame)
 		}
 	}
 
-	// Draw and Save Results
-	if (m_dsp_results && ret == ADAS_SUCCESS)
-		_drawResults();
-
-	if (m_dsp_results && m_dbg_saveImages && ret == ADAS_SUCCESS)
-		_saveDrawResults();
-
-	// Save Raw Images
-	if (m_dbg_saveRawImages)
-		_saveRawImages();
+	// Draw and Save Results, on the render workers (see _submitRenderJob)
+	_submitRenderJob(m_dsp_results && ret == ADAS_SUCCESS,
+					 m_dbg_saveImages,
+					 m_dbg_saveRawImages);
 
 	
 
@@ -757,22 +893,25 @@ bool ADAS::run(cv::Mat &imgFrame)
 	ADAS_Results adasResult;
 	getResults(adasResult);
 	//"{"frameId": id, "pLeftFar.x": adasResult.pLeftFar.x, }"
-	std::vector<BoundingBox> boundingBoxLists[] =
+	const std::vector<BoundingBox>* boundingBoxLists[JSON_LOG_DETECT_NUM_CLASSES] =
 	{
-		m_humanBBoxList,
-		m_riderBBoxList,
-		m_vehicleBBoxList,
-		m_roadSignBBoxList,
-		m_stopSignBBoxList
+		&m_humanBBoxList,
+		&m_riderBBoxList,
+		&m_vehicleBBoxList,
+		&m_roadSignBBoxList,
+		&m_stopSignBBoxList
 	};
-	JSON_LOG json_log("output.json");
-	std::string json_log_str = json_log.JsonLogString(adasResult, 
-													  m_config, 
-													  boundingBoxLists, 
-													  m_trackedObjList, 
-													  m_frameIdx);
+	std::string json_log_str;
+	{
+		ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_JSON_LOG);
+		json_log_str = m_jsonLog->JsonLogString(adasResult, 
+												m_config, 
+												boundingBoxLists, 
+												m_trackedObjList, 
+												m_frameIdx);
+	}
 	
-	std::string json_log_frameID_str = json_log.GetJsonValueByKey(87);
+	// std::string json_log_frameID_str = m_jsonLog->GetJsonValueByKey(87);
 	// cout<<"==========================================================================="<<endl;
 	// cout<<json_log_str<<endl;
 	// cout<<"==========================================================================="<<endl;
@@ -783,6 +922,7 @@ bool ADAS::run(cv::Mat &imgFrame)
 bool ADAS::run(cv::Mat &imgFrame, cv::Mat &resultMat)
 {
  	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer frameTimer(m_stageProfiler, ADAS_STAGE_FRAME);
 	auto time_0 = std::chrono::high_resolution_clock::now();
 	auto time_1 = std::chrono::high_resolution_clock::now();
 
@@ -794,18 +934,9 @@ bool ADAS::run(cv::Mat &imgFrame, cv::Mat &resultMat)
 		return false;
 	}
 
-	int newXStart = static_cast<int>(imgFrame.cols * m_config->startXRatio);
-	int newXEnd = static_cast<int>(imgFrame.cols * m_config->endXRatio);
-	int newYStart = static_cast<int>(imgFrame.rows * m_config->startYRatio);
-	int newYEnd = static_cast<int>(imgFrame.rows * m_config->endYRatio);
-
 	// Get Image Frame
 	if (m_dsp_results)
-	{
-		m_dsp_img = imgFrame.clone();
-		m_dsp_img = m_dsp_img(cv::Range(newYStart, newYEnd), cv::Range(newXStart, newXEnd));
-		cv::resize(m_dsp_img, m_dsp_img, cv::Size(m_config->frameWidth, m_config->frameHeight), cv::INTER_LINEAR);
-	}
+		_getInputFrame(imgFrame, m_dsp_img, m_config->frameWidth, m_config->frameHeight);
 
 	// Entry Point
 	if (m_frameIdx % m_frameStep == 0)
@@ -815,14 +946,13 @@ bool ADAS::run(cv::Mat &imgFrame, cv::Mat &resultMat)
 		m_logger->info("Frame Index: {}", m_frameIdx);
 		m_logger->info("========================================");
 
-		// Get Image Frame
-		m_img = imgFrame.clone();
-		m_img = m_img(cv::Range(newYStart, newYEnd), cv::Range(newXStart, newXEnd));
-		cv::resize(m_img, m_img, cv::Size(m_config->modelWidth, m_config->modelHeight), cv::INTER_LINEAR);
+		// Get Image Frame, shared by optical flow, YOLO-ADAS and the trackers
+		_getInputFrame(imgFrame, m_img, m_config->modelWidth, m_config->modelHeight);
 
 		// Update YOLO-ADAS frame buffer
 		m_opticalFlow->updateInputFrame(m_img);
-		m_yoloADAS->updateInputFrame(m_img);
+		if (!m_replayResultFunc)
+			m_yoloADAS->updateInputFrame(m_img);
 
 		// Calculate Ego Direction Information
 		if (!_calcEgoDirection())
@@ -831,69 +961,50 @@ bool ADAS::run(cv::Mat &imgFrame, cv::Mat &resultMat)
 			ret = ADAS_FAILURE;
 		}
 
-		// Get last prediction
-		YOLOADAS_Prediction pred;
-		int predBufferSize = m_yoloADAS->getLastestPrediction(pred);
-		if (predBufferSize > 0)
+		bool isResultReady = false;
+		if (m_replayResultFunc)
 		{
-			// Start doing post processing ...
-			m_yoloADAS_PostProc->updatePredictionBuffer(pred);
-			m_yoloADAS->removeFirstPrediction();
-
+			// Offline replay: recorded result instead of YOLO-ADAS
 			m_procResult = {};
-			int resultBufferSize = m_yoloADAS_PostProc->getLastestResult(m_procResult);
-
-			if (resultBufferSize == 0)
-			{
-				return false;
-			}
-
+			isResultReady = m_replayResultFunc(m_procResult);
+		}
+		else
+		{
+			// Get last prediction
+			YOLOADAS_Prediction pred;
+			int predBufferSize = m_yoloADAS->getLastestPrediction(pred);
+			if (predBufferSize > 0)
 			{
-				// Get Lane Line Masks
-				if (!_getLaneLineMasks())
-				{
-					m_logger->warn("Get lane line mask failed ...");
-					ret = ADAS_FAILURE;
-				}
-
-				// Lane Line Detection
-				if (!_laneLineDetection())
-				{
-					m_logger->warn("Detect lane lines failed ...");
-					ret = ADAS_FAILURE;
-				}
+				// Start doing post processing ...
+				m_yoloADAS_PostProc->updatePredictionBuffer(pred);
+				m_yoloADAS->removeFirstPrediction();
 
-				// Get Detected Bounding Boxes
-				if (!_objectDetection())
-				{
-					m_logger->warn("Detect objects failed ...");
-					ret = ADAS_FAILURE;
-				}
+				m_procResult = {};
+				int resultBufferSize = m_yoloADAS_PostProc->getLastestResult(m_procResult);
 
-				// Object Tracking
-				if (!_objectTracking())
+				if (resultBufferSize == 0)
 				{
-					m_logger->warn("Track objects failed ...");
-					ret = ADAS_FAILURE;
+					return false;
 				}
 
-				// Detect Lane Departure Event
-				if (!_laneDepartureDetection())
-				{
-					m_logger->warn("Detect lane departure event failed ...");
-					ret = ADAS_FAILURE;
-				}
+				isResultReady = true;
+			}
+		}
 
-				// Forward Collision Warning
-				if (!_forwardCollisionDetection())
-				{
-					m_logger->warn("Detect forward collision event failed ...");
+		if (isResultReady)
+		{
+			{
+				// Lane lines, objects, tracking, LDW and FCW (see _initStageGraph)
+				if (!m_stageGraph->run())
 					ret = ADAS_FAILURE;
-				}
 			}
 
 			// End of ADAS Tasks
-			m_yoloADAS_PostProc->removeFirstResult();
+			if (!m_replayResultFunc)
+				m_yoloADAS_PostProc->removeFirstResult();
+
+			// Rescale boxes to frame size once for drawing and logging
+			_rescaleResults();
 
 			// Show Results
 			_showDetectionResults();
@@ -913,16 +1024,10 @@ bool ADAS::run(cv::Mat &imgFrame, cv::Mat &resultMat)
 		}
 	}
 
-	// Draw and Save Results
-	if (m_dsp_results && ret == ADAS_SUCCESS)
-		_drawResults();
-
-	if (m_dsp_results && m_dbg_saveImages && ret == ADAS_SUCCESS)
-		_saveDrawResults();
-
-	// Save Raw Images
-	if (m_dbg_saveRawImages)
-		_saveRawImages();
+	// Draw and Save Results, on the render workers (see _submitRenderJob)
+	_submitRenderJob(m_dsp_results && ret == ADAS_SUCCESS,
+					 m_dbg_saveImages,
+					 m_dbg_saveRawImages);
 
 	getResultImage(resultMat); // copy resized_dsp_img to resultMat
 
@@ -933,30 +1038,15 @@ bool ADAS::run(cv::Mat &imgFrame, cv::Mat &resultMat)
 	ADAS_Results adasResult;
 	getResults(adasResult);
 	//"{"frameId": id, "pLeftFar.x": adasResult.pLeftFar.x, }"
-	std::vector<BoundingBox> boundingBoxLists[] =
 	{
-		m_humanBBoxList,
-		m_riderBBoxList,
-		m_vehicleBBoxList,
-		m_roadSignBBoxList,
-		m_stopSignBBoxList
-	};
-	JSON_LOG json_log("output.json");
-	// std::string json_log_str = json_log.JsonLogString(adasResult, 
-	// 												  m_config, 
-	// 												  boundingBoxLists, 
-	// 												  m_trackedObjList, 
-	// 												  m_frameIdx);
-	std::string json_log_str = json_log.JsonLogString_2(adasResult,
-														m_config,
-														m_humanBBoxList,
-														m_riderBBoxList,
-														m_vehicleBBoxList,
-														m_roadSignBBoxList,
-														m_stopSignBBoxList,
-														m_trackedObjList,
-														m_frameIdx);
-	// std::string json_log_frameID_str = json_log.GetJsonValueByKey(87);
+		ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_JSON_LOG);
+		m_jsonLog->LogFrame(adasResult,
+							m_rescaledDetectionTable,
+							m_rescaledTrackBBoxList,
+							m_trackedObjList,
+							m_frameIdx);
+	}
+	// std::string json_log_frameID_str = m_jsonLog->GetJsonValueByKey(87);
 	// cout<<"==========================================================================="<<endl;
 	// cout<<json_log_str<<endl;
 	// cout<<"==========================================================================="<<endl;
@@ -1093,6 +1183,9 @@ void WNC_ADAS::IpuRunProcess()
 						FRAME_SUCCESS = ADAS_FAILURE;
 					}
 
+					// Rescale boxes to frame size once for drawing and logging
+					_rescaleResults();
+
 					// Show Results
 					_showDetectionResults();
 
@@ -1116,14 +1209,9 @@ void WNC_ADAS::IpuRunProcess()
             }
 
             // Draw and Save Results
-            if (m_dsp_results && FRAME_SUCCESS == ADAS_SUCCESS)
-                _drawResults();
-
-            if (m_dsp_results && m_dbg_saveImages && FRAME_SUCCESS == ADAS_SUCCESS)
-                _saveDrawResults();
-
-            if (m_dbg_saveRawImages)
-                _saveRawImages();
+            _submitRenderJob(m_dsp_results && FRAME_SUCCESS == ADAS_SUCCESS,
+                             m_dbg_saveImages,
+                             m_dbg_saveRawImages);
 
             FRAME_SUCCESS = ADAS_SUCCESS;
 
@@ -1246,10 +1334,10 @@ bool WNC_ADAS::_scaleToModelSize(MI_SYS_BufInfo_t* pstBufInfo)
 
     if (m_dsp_results)
         // TODO: cv::cvtColor(imgFrame, m_dsp_img, cv::COLOR_RGBA2RGB);
-        m_dsp_img = imgFrame.clone();
+        m_dsp_img = m_framePool->clone(imgFrame);
 
     // Entry Point
-    m_img = imgFrame.clone();
+    m_img = m_framePool->clone(imgFrame);
 
     memcpy(pDstImage, imgFrame.data, u16ModelWidth * u16ModelHeight * 4);
     // cv::imwrite("input.jpg", m_img); // wnc modify to check input image
@@ -1259,20 +1347,49 @@ bool WNC_ADAS::_scaleToModelSize(MI_SYS_BufInfo_t* pstBufInfo)
 }
 #endif
 
+// Crop the configured ROI of the input as a view and resize it once into an
+// unshared pool buffer. The buffer is never written again, so it can be
+// shared with the threads that still hold the frames before it.
+void ADAS::_getInputFrame(const cv::Mat& imgFrame, cv::Mat& imgOut, int width, int height)
+{
+	int newXStart = static_cast<int>(imgFrame.cols * m_config->startXRatio);
+	int newXEnd = static_cast<int>(imgFrame.cols * m_config->endXRatio);
+	int newYStart = static_cast<int>(imgFrame.rows * m_config->startYRatio);
+	int newYEnd = static_cast<int>(imgFrame.rows * m_config->endYRatio);
+
+	cv::Mat imgROI = imgFrame(cv::Range(newYStart, newYEnd), cv::Range(newXStart, newXEnd));
+
+	imgOut = m_framePool->acquire(height, width, imgFrame.type());
+	cv::resize(imgROI, imgOut, cv::Size(width, height), cv::INTER_LINEAR);
+}
+
+bool ADAS::_runStage(bool (ADAS::*stageFunc)(), const char* failMessage)
+{
+	auto m_logger = spdlog::get("ADAS");
+
+	if (!(this->*stageFunc)())
+	{
+		m_logger->warn(failMessage);
+		return ADAS_FAILURE;
+	}
+
+	return ADAS_SUCCESS;
+}
+
 bool ADAS::_calcEgoDirection()
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_EGO_DIRECTION);
 
 	bool isReady = false;
 
 	if (m_opticalFlow->isProcessDone())
 	{
-		std::vector<BoundingBox> bboxList;
-
-		bboxList.insert(bboxList.end(), m_humanBBoxList.begin(), m_humanBBoxList.end());
-		bboxList.insert(bboxList.end(), m_riderBBoxList.begin(), m_riderBBoxList.end());
-		bboxList.insert(bboxList.end(), m_vehicleBBoxList.begin(), m_vehicleBBoxList.end());
-		m_opticalFlow->getFlow(bboxList);
+		// Human, rider and vehicle are adjacent ranges of the detection table,
+		// the flow gets the whole detector boxes (objID, boxID, ...)
+		m_detectionTable.copyBoxes(
+			m_detectionTable.classRange(DETECT_CLASS_HUMAN, DETECT_CLASS_VEHICLE), m_detectBBoxList);
+		m_opticalFlow->getFlow(m_detectBBoxList);
 		m_opticalFlow->getDirectionInfo(m_egoDirectionInfo);
 		m_opticalFlow->getDirection(m_egoDirectionInfo);
 
@@ -1286,10 +1403,13 @@ bool ADAS::_calcEgoDirection()
 bool ADAS::_getLaneLineMasks()
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_LANE_LINE_MASKS);
 
+	// m_procResult is refilled every frame, take its data instead of copying
+	// (cv::Mat assignments only share the pixel buffers)
 	m_laneMask = m_procResult.laneMask;
 	m_horiLineMask = m_procResult.horiLineMask;
-	m_laneLineInfo = m_procResult.laneLineInfo;
+	m_laneLineInfo = std::move(m_procResult.laneLineInfo);
 
 	if (m_dsp_laneLineMask)
 	{
@@ -1313,6 +1433,7 @@ bool ADAS::_modelInfernece()
 bool ADAS::_laneLineDetection()
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_LANE_LINE_DETECTION);
 
 	m_currLaneInfo = m_laneFinder->find(m_laneMask, m_laneLineInfo);
 	m_unscale_currLaneInfo = m_laneFinder->getUnscaleLaneInfo();
@@ -1355,6 +1476,7 @@ bool ADAS::_laneLineDetection()
 bool ADAS::_laneDepartureDetection()
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_LANE_DEPARTURE);
 
 	if (m_isDetectLine)
 	{
@@ -1412,11 +1534,15 @@ bool ADAS::_laneDepartureDetection()
 bool ADAS::_objectDetection()
 {
 	auto m_logger = spdlog::get("ADAS");
-	m_humanBBoxList = m_procResult.humanBBoxList;
-	m_riderBBoxList = m_procResult.riderBBoxList;
-	m_vehicleBBoxList = m_procResult.vehicleBBoxList;
-	m_roadSignBBoxList = m_procResult.roadSignBBoxList;
-	m_stopSignBBoxList = m_procResult.stopSignBBoxList;
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_OBJECT_DETECTION);
+	// Take the boxes of this frame, m_procResult is refilled every frame
+	m_humanBBoxList = std::move(m_procResult.humanBBoxList);
+	m_riderBBoxList = std::move(m_procResult.riderBBoxList);
+	m_vehicleBBoxList = std::move(m_procResult.vehicleBBoxList);
+	m_roadSignBBoxList = std::move(m_procResult.roadSignBBoxList);
+	m_stopSignBBoxList = std::move(m_procResult.stopSignBBoxList);
+
+	_buildDetectionTable();
 
 	m_fcw->humanBoxFilter(m_humanBBoxList, m_f_humanBBoxList);
 	m_fcw->riderBoxFilter(m_riderBBoxList, m_f_riderBBoxList);
@@ -1444,13 +1570,21 @@ bool ADAS::_objectDetection()
 bool ADAS::_objectTracking()
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_OBJECT_TRACKING);
 	// Update FCW Data Buffer for Calculating TTC Before Tracking Objects
 	m_fcw->updateDataBuffer(m_img, *m_roiBBox);
 
 	// Run Object Tracking
-	m_humanTracker->run(m_img, m_f_humanBBoxList, m_yVanish, m_roi);
-	m_riderTracker->run(m_img, m_f_riderBBoxList, m_yVanish, m_roi);
-	m_vehicleTracker->run(m_img, m_f_vehicleBBoxList, m_yVanish, m_roi);
+	if (m_parallelTracking)
+	{
+		_runTrackersParallel();
+	}
+	else
+	{
+		m_humanTracker->run(m_img, m_f_humanBBoxList, m_yVanish, m_roi);
+		m_riderTracker->run(m_img, m_f_riderBBoxList, m_yVanish, m_roi);
+		m_vehicleTracker->run(m_img, m_f_vehicleBBoxList, m_yVanish, m_roi);
+	}
 
 	// Get Tracked Objects
 	m_humanTracker->getObjectList(m_humanObjList);
@@ -1470,9 +1604,35 @@ bool ADAS::_objectTracking()
 	return ADAS_SUCCESS;
 }
 
+void ADAS::_runTrackersParallel()
+{
+	ObjectTracker* trackers[] = {m_humanTracker, m_riderTracker, m_vehicleTracker};
+	std::vector<BoundingBox>* bboxLists[] = {&m_f_humanBBoxList, &m_f_riderBBoxList, &m_f_vehicleBBoxList};
+	const int numTrackers = sizeof(trackers) / sizeof(trackers[0]);
+
+	// Every tracker holds the FCW data buffer (setDataBuffer), nothing guards
+	// it here: only enabled through ADAS_PARALLEL_TRACKING / setParallelTracking
+	std::atomic<int> numDone{0};
+	for (int i = 0; i < numTrackers; i++)
+	{
+		ObjectTracker* tracker = trackers[i];
+		std::vector<BoundingBox>* bboxList = bboxLists[i];
+
+		m_workerPool->submit([this, tracker, bboxList, &numDone]
+		{
+			tracker->run(m_img, *bboxList, m_yVanish, m_roi);
+			numDone++;
+		});
+	}
+
+	// Join barrier, the waiting thread runs trackers too
+	m_workerPool->waitUntil([&numDone, numTrackers] { return numDone.load() == numTrackers; });
+}
+
 bool ADAS::_forwardCollisionDetection()
 {
 	auto m_logger = spdlog::get("ADAS");
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_FORWARD_COLLISION);
 
 	m_isForwardCollision = m_fcw->run(m_img, m_trackedObjList, m_yVanish);
 
@@ -1561,12 +1721,79 @@ float ADAS::getFollowingDistance()
 	return followDistance;
 }
 
+void ADAS::showStageLatency()
+{
+	auto m_logger = spdlog::get("ADAS");
+
+	m_logger->info("");
+	m_logger->info("Stage Latency");
+	m_logger->info("---------------------------------");
+
+	std::stringstream summary(m_stageProfiler->getSummary());
+	std::string line;
+	while (std::getline(summary, line))
+		m_logger->info(line);
+}
+
+bool ADAS::saveStageTrace(const std::string& tracePath)
+{
+	auto m_logger = spdlog::get("ADAS");
+
+	if (!m_stageProfiler->saveChromeTrace(tracePath))
+	{
+		m_logger->warn("Save stage trace to {} failed", tracePath);
+		return ADAS_FAILURE;
+	}
+
+	m_logger->info("Save stage trace to {}", tracePath);
+	return ADAS_SUCCESS;
+}
+
+void ADAS::showMemoryUsage()
+{
+	auto m_logger = spdlog::get("ADAS");
+
+	m_logger->info("");
+	m_logger->info("Memory Usage");
+	m_logger->info("---------------------------------");
+	m_logger->info("Frame arena: peak {} bytes, capacity {} bytes, {} overflows",
+				   m_frameArena->getPeakBytes(), m_frameArena->getCapacity(),
+				   m_frameArena->getNumOverflows());
+	m_logger->info("Frame pool: {} buffers ({} bytes), high-water mark {}, {} hits, {} misses",
+				   m_framePool->getNumBuffers(), m_framePool->getPooledBytes(),
+				   m_framePool->getHighWaterMark(), m_framePool->getNumHits(),
+				   m_framePool->getNumMisses());
+
+	std::lock_guard<std::mutex> lock(m_renderMutex);
+	m_logger->info("Render: {} jobs, {} dropped", m_numRenderJobs, m_numDroppedRenders);
+}
+
+#ifdef QCS6490
+void ADAS::setReplaySource(std::function<bool(POST_PROC_RESULTS& result)> func)
+{
+	m_replayResultFunc = std::move(func);
+}
+#endif
+
 void ADAS::getResultImage(cv::Mat &imgResult)
 {
+	// Latest rendered frame, may be behind the processed one
+	std::lock_guard<std::mutex> lock(m_mutex);
 	if (m_dsp_results)
 		imgResult = m_dsp_imgResize;
 }
 
+// Tracked objects of the last processed frame (human, rider, vehicle)
+void ADAS::getTrackedObjects(std::vector<Object> &objList)
+{
+	objList = m_trackedObjList;
+}
+
+void ADAS::setParallelTracking(bool enable)
+{
+	m_parallelTracking = enable;
+}
+
 // ============================================
 //                  Results
 // ============================================
@@ -1597,7 +1824,7 @@ void ADAS::_showDetectionResults()
 
 		if (obj.status == 1)
 		{
-			string classType = "";
+			const char* classType = "";
 			if (obj.bbox.label == HUMAN)
 				classType = "Pedestrian";
 			else if (obj.bbox.label == SMALL_VEHICLE)
@@ -1672,15 +1899,10 @@ void ADAS::_saveDetectionResults()
 	_saveDetectionResult(m_loggerManager.m_lineDetetionLogger->m_logs);
 
 	// --- Object Detection --- //
-	std::vector<BoundingBox> bboxList;
-
-	bboxList.insert(bboxList.end(), m_humanBBoxList.begin(), m_humanBBoxList.end());
-	bboxList.insert(bboxList.end(), m_riderBBoxList.begin(), m_riderBBoxList.end());
-	bboxList.insert(bboxList.end(), m_vehicleBBoxList.begin(), m_vehicleBBoxList.end());
-	bboxList.insert(bboxList.end(), m_roadSignBBoxList.begin(), m_roadSignBBoxList.end());
-	bboxList.insert(bboxList.end(), m_stopSignBBoxList.begin(), m_stopSignBBoxList.end());
+	// Whole detector boxes, the logger prints more than the table columns
+	m_detectionTable.copyBoxes(m_detectionTable.all(), m_detectBBoxList);
 
-	m_loggerManager.m_objectDetectionLogger->logObjects(bboxList);
+	m_loggerManager.m_objectDetectionLogger->logObjects(m_detectBBoxList);
 	m_logger->info("");
 	m_logger->info("Object Detection");
 	m_logger->info("---------------------------------");
@@ -1715,25 +1937,25 @@ void ADAS::_saveDetectionResults()
 	_saveDetectionResult(m_loggerManager.m_forwardCollisionWarningLogger->m_logs);
 }
 
-void ADAS::_saveDrawResults()
+void ADAS::_saveDrawResults(const ADAS_DRAW_RESULTS& drawResult)
 {
 	auto m_logger = spdlog::get("ADAS");
 
-	string imgName = "frame_" + std::to_string(m_frameIdx) + ".jpg";
+	string imgName = "frame_" + std::to_string(drawResult.frameIdx) + ".jpg";
 	string imgPath = m_dbg_imgsDirPath + "/" + imgName;
 
-	cv::imwrite(imgPath, m_dsp_imgResize);
+	cv::imwrite(imgPath, drawResult.matResult);
 	m_logger->debug("Save img to {}", imgPath);
 }
 
-void ADAS::_saveRawImages()
+void ADAS::_saveRawImages(const ADAS_DRAW_RESULTS& drawResult)
 {
 	auto m_logger = spdlog::get("ADAS");
 
-	string imgName = "frame_" + std::to_string(m_frameIdx) + ".jpg";
+	string imgName = "frame_" + std::to_string(drawResult.frameIdx) + ".jpg";
 	string imgPath = m_dbg_rawImgsDirPath + "/" + imgName;
 
-	cv::imwrite(imgPath, m_img);
+	cv::imwrite(imgPath, drawResult.matRawImage);
 	m_logger->debug("Save raw img to {}", imgPath);
 }
 
@@ -1748,24 +1970,18 @@ void ADAS::_drawLaneDetector()
   cv::line(m_dsp_img, m_laneDetector.pTailRight, m_laneDetector.pHeadRight, cv::Scalar(0, 255, 0), 2, cv::LINE_AA);
 }
 
-void ADAS::_drawLDWROI()
+void ADAS::_drawLDWROI(ADAS_DRAW_RESULTS& drawResult)
 {
-	float scale_ratio = m_dsp_img.cols / m_maskWidth;
-	scale_ratio = m_dsp_img.cols / m_segWidth;
-	int middle_x = (int)(m_laneLineInfo.laneMaskInfo.xCenterAdjust * scale_ratio);
-	cv::line(m_dsp_img, cv::Point(middle_x, 0), cv::Point(middle_x, m_dsp_img.rows - 1), cv::Scalar(255, 255, 255), 2);
+	cv::Mat& img = drawResult.matImage;
+	float scale_ratio = img.cols / m_maskWidth;
+	scale_ratio = img.cols / m_segWidth;
+	int middle_x = (int)(drawResult.xCenterAdjust * scale_ratio);
+	cv::line(img, cv::Point(middle_x, 0), cv::Point(middle_x, img.rows - 1), cv::Scalar(255, 255, 255), 2);
 }
 
-void ADAS::_drawBoundingBoxes()
+void ADAS::_drawBoundingBoxes(ADAS_DRAW_RESULTS& drawResult)
 {
-	std::vector<BoundingBox> boundingBoxLists[] =
-	{
-		m_humanBBoxList,
-		m_riderBBoxList,
-		m_vehicleBBoxList,
-		m_roadSignBBoxList,
-		m_stopSignBBoxList};
-
+	// Rescaled by _rescaleResults(), human, rider, vehicle, road sign, stop sign
 	cv::Scalar colors[] =
 	{
 		cv::Scalar(0, 255, 0),     // Green for vehicles
@@ -1775,40 +1991,35 @@ void ADAS::_drawBoundingBoxes()
 		cv::Scalar(196, 62, 255)   // Purple for stop signs
 	};
 
-	for (int j = 0; j < sizeof(boundingBoxLists) / sizeof(boundingBoxLists[0]); j++)
+	const std::vector<BoundingBox>* bboxLists[] =
+	{
+		&drawResult.humanBBoxList,
+		&drawResult.riderBBoxList,
+		&drawResult.vehicleBBoxList,
+		&drawResult.roadSignBBoxList,
+		&drawResult.stopSignBBoxList
+	};
+
+	for (int j = 0; j < DETECT_NUM_CLASSES; j++)
 	{
-		std::vector<BoundingBox>& boundingBoxList = boundingBoxLists[j];
+		const std::vector<BoundingBox>& bboxList = *bboxLists[j];
 		cv::Scalar color = colors[j];
 
-		for (int i = 0; i < boundingBoxList.size(); i++)
+		for (size_t i = 0; i < bboxList.size(); i++)
 		{
-			BoundingBox lastBox = boundingBoxList[i];
-			BoundingBox rescaleBox(-1, -1, -1, -1, -1);
-
-			#ifdef QCS6490
-			utils::rescaleBBox(
-			lastBox, rescaleBox,
-			m_config->modelWidth, m_config->modelHeight,
-			m_config->frameWidth, m_config->frameHeight);
-			#endif
-
-			#ifdef SAV837
-			utils::rescaleBBox(
-			lastBox, rescaleBox,
-			m_config->modelWidth, m_config->modelHeight,
-			m_config->frameWidth, m_config->frameHeight);
-			#endif
-
+			const BoundingBox& box = bboxList[i];
 			imgUtil::roundedRectangle(
-				m_dsp_img, cv::Point(rescaleBox.x1, rescaleBox.y1),
-				cv::Point(rescaleBox.x2, rescaleBox.y2),
+				drawResult.matImage, cv::Point(box.x1, box.y1),
+				cv::Point(box.x2, box.y2),
 				color, 2, 0, 10, false);
 		}
 	}
 }
 
-void ADAS::_drawTrackedObjects()
+void ADAS::_drawTrackedObjects(ADAS_DRAW_RESULTS& drawResult)
 {
+	cv::Mat& img = drawResult.matImage;
+
 	// Drawing zones if dsp_warningZone is true
 	if (m_dsp_warningZone)
 	{
@@ -1817,89 +2028,76 @@ void ADAS::_drawTrackedObjects()
 		ROI fcw_human_roi;
 
 		utils::rescaleROI(
-		m_fcw->m_vehicleROI, fcw_vehicle_roi,
+		drawResult.vehicleROI, fcw_vehicle_roi,
 		m_config->modelWidth, m_config->modelHeight,
 		m_videoWidth, m_videoHeight);
 
 		imgUtil::roundedRectangle(
-			m_dsp_img,
+			img,
 			cv::Point(fcw_vehicle_roi.x1, fcw_vehicle_roi.y1),
 			cv::Point(fcw_vehicle_roi.x2, fcw_vehicle_roi.y2),
 			cv::Scalar(255, 255, 255),
 			2, 0, 10, false);
 
 		utils::rescaleROI(
-		m_fcw->m_riderROI, fcw_rider_roi,
+		drawResult.riderROI, fcw_rider_roi,
 		m_config->modelWidth, m_config->modelHeight,
 		m_videoWidth, m_videoHeight);
 
 		imgUtil::roundedRectangle(
-			m_dsp_img,
+			img,
 			cv::Point(fcw_rider_roi.x1, fcw_rider_roi.y1),
 			cv::Point(fcw_rider_roi.x2, fcw_rider_roi.y2),
 			cv::Scalar(0, 128, 255),
 			2, 0, 10, false);
 
 		utils::rescaleROI(
-		m_fcw->m_humanROI, fcw_human_roi,
+		drawResult.humanROI, fcw_human_roi,
 		m_config->modelWidth, m_config->modelHeight,
 		m_videoWidth, m_videoHeight);
 
 		imgUtil::roundedRectangle(
-			m_dsp_img,
+			img,
 			cv::Point(fcw_human_roi.x1, fcw_human_roi.y1),
 			cv::Point(fcw_human_roi.x2, fcw_human_roi.y2),
 			cv::Scalar(0, 0, 255),
 			2, 0, 10, false);
 	}
 
-	for (int i = 0; i < m_trackedObjList.size(); i++)
+	for (int i = 0; i < drawResult.trackedObjList.size(); i++)
 	{
-		const Object& trackedObj = m_trackedObjList[i];
+		const Object& trackedObj = drawResult.trackedObjList[i];
 
 		// Skip objects with specific conditions
 		if (trackedObj.status == 0 || trackedObj.disappearCounter > 5 || trackedObj.bboxList.empty())
 			continue;
 		// if (trackedObj.bboxList.empty())
 		// 	continue;
+		if (i >= drawResult.trackBBoxList.size())
+			break;
 
-		BoundingBox lastBox = trackedObj.bboxList.back();
-		BoundingBox rescaleBox(-1, -1, -1, -1, -1);
-
-		// Rescale BBoxes
-		#ifdef SAV837
-		utils::rescaleBBox(
-		lastBox, rescaleBox,
-		m_config->modelWidth, m_config->modelHeight,
-		m_config->frameWidth, m_config->frameHeight);
-		#endif
-
-		#ifdef QCS6490
-		utils::rescaleBBox(
-		lastBox, rescaleBox,
-		m_config->modelWidth, m_config->modelHeight,
-		m_config->frameWidth, m_config->frameHeight);
-		#endif
+		// Rescaled by _rescaleResults()
+		const BoundingBox& rescaleBox = drawResult.trackBBoxList[i];
 
 		if (trackedObj.aliveCounter < 3)
 		{
 			imgUtil::efficientRectangle(
-			m_dsp_img, cv::Point(rescaleBox.x1, rescaleBox.y1),
+			img, cv::Point(rescaleBox.x1, rescaleBox.y1),
 			cv::Point(rescaleBox.x2, rescaleBox.y2),
 			cv::Scalar(0, 250, 0), 2, 0, 10, false);
 		}
 		else
 		{
 			cv::Scalar color;
-			if (lastBox.label == 0) // Human
+			if (rescaleBox.label == 0) // Human
 				color = cv::Scalar(255, 51, 153);  // Purple 
-			else if (lastBox.label == 1) // Rider
+			else if (rescaleBox.label == 1) // Rider
 				color = cv::Scalar(255, 51, 255);  // Pink
-			else if (lastBox.label == 2) // Vehicle
+			else if (rescaleBox.label == 2) // Vehicle
 				color = cv::Scalar(255, 153, 153); // Purple Blue
 
 			imgUtil::efficientRectangle(
-			m_dsp_img, cv::Point(rescaleBox.x1, rescaleBox.y1),
+			img, cv::Point(rescaleBox.x1, rescaleBox.y1),
 			cv::Point(rescaleBox.x2, rescaleBox.y2),
 			color, 2, 0, 10, false);
 		}
@@ -1911,11 +2109,11 @@ void ADAS::_drawTrackedObjects()
 			if (distance >= 0 && !std::isnan(distance)) // Show distance if it is positive 
 			{
 				// Text box
-				cv::rectangle(m_dsp_img, cv::Point(rescaleBox.x1 + 10, rescaleBox.y1 - 20),
+				cv::rectangle(img, cv::Point(rescaleBox.x1 + 10, rescaleBox.y1 - 20),
 							  cv::Point(rescaleBox.x1 + 40, rescaleBox.y1 - 3), (0, 0, 0), -1
 							  /*fill*/);
 
-				cv::putText(m_dsp_img, std::to_string(trackedObj.id) + ":" + std::to_string((int)distance) + "m",
+				cv::putText(img, std::to_string(trackedObj.id) + ":" + std::to_string((int)distance) + "m",
 							cv::Point(int(rescaleBox.x1) + 10, int(rescaleBox.y1) - 10), cv::FONT_HERSHEY_DUPLEX,
 							0.3, cv::Scalar(255, 255, 255), 1, 5, 0);
 			}
@@ -1933,19 +2131,19 @@ void ADAS::_drawTrackedObjects()
 			{
 				// Draw bounding box in red
 				imgUtil::efficientRectangle(
-				m_dsp_img, cv::Point(rescaleBox.x1, rescaleBox.y1),
+				img, cv::Point(rescaleBox.x1, rescaleBox.y1),
 				cv::Point(rescaleBox.x2, rescaleBox.y2),
 				cv::Scalar(0, 0, 255), 2, 0, 10, false);
 
 				// Draw TTC information
 				cv::rectangle(
-				m_dsp_img,
+				img,
 				cv::Point(rescaleBox.x1 + 10, rescaleBox.y2 + 3),
 				cv::Point(rescaleBox.x1 + 88, rescaleBox.y2 + 35),
 				(0, 0, 0),
 				-1/*fill*/);
 
-				cv::putText(m_dsp_img, ttcString,
+				cv::putText(img, ttcString,
 				cv::Point(int(rescaleBox.x1) + 20, int(rescaleBox.y2) + 28),
 				cv::FONT_HERSHEY_DUPLEX, 0.6,
 				cv::Scalar(255, 255, 255), 1, 5, 0);
@@ -1955,10 +2153,10 @@ void ADAS::_drawTrackedObjects()
 
 	if (m_dsp_vanishingLine)
 #ifdef QCS6490
-		cv::line(m_dsp_img, cv::Point(0, m_yVanish), cv::Point(m_videoWidth, m_yVanish), cv::Scalar(255, 255, 255), 2);
+		cv::line(img, cv::Point(0, drawResult.yVanish), cv::Point(m_videoWidth, drawResult.yVanish), cv::Scalar(255, 255, 255), 2);
 #endif
 #ifdef SAV837
-		cv::line(m_dsp_img, cv::Point(0, m_yVanish), cv::Point(m_videoWidth, m_yVanish), cv::Scalar(255, 255, 255), 2);
+		cv::line(img, cv::Point(0, drawResult.yVanish), cv::Point(m_videoWidth, drawResult.yVanish), cv::Scalar(255, 255, 255), 2);
 #endif
 }
 
@@ -1996,21 +2194,11 @@ void ADAS::_drawCrossWalk()
 	cv::addWeighted(m_dsp_img, 1.0, m_dsp_calibMask, 0.7, 0.0, m_dsp_img);
 }
 
-void ADAS::_drawLaneLines()
+void ADAS::_drawLaneLines(ADAS_DRAW_RESULTS& drawResult)
 {
-	#ifdef SAV837
-	utils::rescaleLine(
-		m_fcw->m_vehicleZone, m_rescaleVehicleROI,
-		m_config->modelWidth, m_config->modelHeight,
-		m_config->frameWidth, m_config->frameHeight);
-	#endif
-
-	#ifdef QCS6490
-	utils::rescaleLine(
-		m_fcw->m_vehicleZone, m_rescaleVehicleROI,
-		m_config->modelWidth, m_config->modelHeight,
-		m_config->frameWidth, m_config->frameHeight);
-	#endif
+	// Vehicle zone is rescaled to frame size by _getDrawResults()
+	cv::Mat& img = drawResult.matImage;
+	const ROI& vehicleZone = drawResult.vehicleZone;
 
 	// if (m_dsp_warningZone)
 	// {
@@ -2039,25 +2227,25 @@ void ADAS::_drawLaneLines()
 	// 	#endif
 	// }
 
-	m_dsp_laneLineResult = cv::Mat::zeros(m_dsp_img.rows, m_dsp_img.cols, CV_8UC3); // QD: Change to m_dsp_img for avoiding manual change
+	cv::Mat laneLineResult = cv::Mat::zeros(img.rows, img.cols, CV_8UC3); // QD: Change to img for avoiding manual change
 
-	if (m_rescaleVehicleROI.pLeftFar.y != 0 && m_rescaleVehicleROI.pRightFar.y != 0)
+	if (vehicleZone.pLeftFar.y != 0 && vehicleZone.pRightFar.y != 0)
 	{
 		std::vector<cv::Point> fillContSingle;
-		fillContSingle.push_back(m_rescaleVehicleROI.pLeftFar);
-		fillContSingle.push_back(m_rescaleVehicleROI.pRightFar);
-		fillContSingle.push_back(m_rescaleVehicleROI.pRightCarhood);
-		fillContSingle.push_back(m_rescaleVehicleROI.pLeftCarhood);
+		fillContSingle.push_back(vehicleZone.pLeftFar);
+		fillContSingle.push_back(vehicleZone.pRightFar);
+		fillContSingle.push_back(vehicleZone.pRightCarhood);
+		fillContSingle.push_back(vehicleZone.pLeftCarhood);
 
-		if (m_isLaneDeparture)
-			cv::fillPoly(m_dsp_laneLineResult, std::vector<std::vector<cv::Point>>{fillContSingle}, cv::Scalar(0, 0, 255));
+		if (drawResult.isLaneDeparture)
+			cv::fillPoly(laneLineResult, std::vector<std::vector<cv::Point>>{fillContSingle}, cv::Scalar(0, 0, 255));
 		else
-			cv::fillPoly(m_dsp_laneLineResult, std::vector<std::vector<cv::Point>>{fillContSingle}, cv::Scalar(255, 0, 0));
+			cv::fillPoly(laneLineResult, std::vector<std::vector<cv::Point>>{fillContSingle}, cv::Scalar(255, 0, 0));
 
-		cv::addWeighted(m_dsp_img, 1.0, m_dsp_laneLineResult, 0.7, 0, m_dsp_img);
+		cv::addWeighted(img, 1.0, laneLineResult, 0.7, 0, img);
 
-		cv::line(m_dsp_img, m_rescaleVehicleROI.pLeftFar, m_rescaleVehicleROI.pLeftCarhood, cv::Scalar(255, 255, 255), 2, cv::LINE_AA);
-		cv::line(m_dsp_img, m_rescaleVehicleROI.pRightFar, m_rescaleVehicleROI.pRightCarhood, cv::Scalar(255, 255, 255), 2, cv::LINE_AA);
+		cv::line(img, vehicleZone.pLeftFar, vehicleZone.pLeftCarhood, cv::Scalar(255, 255, 255), 2, cv::LINE_AA);
+		cv::line(img, vehicleZone.pRightFar, vehicleZone.pRightCarhood, cv::Scalar(255, 255, 255), 2, cv::LINE_AA);
 
 		// if (m_dsp_warningZone)
 		// {
@@ -2070,179 +2258,309 @@ void ADAS::_drawLaneLines()
 	}
 }
 
-void ADAS::_drawInformation()
+void ADAS::_drawInformation(ADAS_DRAW_RESULTS& drawResult)
 {
+	cv::Mat& img = drawResult.matResult;
+
 	#ifdef SAV837
-    int m_frameIdx = m_frameIdx_wnc;
+    int frameIdx = m_frameIdx_wnc;
+	#else
+    int frameIdx = drawResult.frameIdx;
 	#endif
 
-    cv::putText(m_dsp_imgResize, "Frame: " + std::to_string(m_frameIdx), cv::Point(10, 500),
+    cv::putText(img, "Frame: " + std::to_string(frameIdx), cv::Point(10, 500),
                 cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 2, 0);
 
-    cv::putText(m_dsp_imgResize, "Direction: " + m_egoDirectionInfo.directionStr, cv::Point(10, 520),
+    cv::putText(img, "Direction: " + drawResult.egoDirectionInfo.directionStr, cv::Point(10, 520),
                 cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 3, 0);
 
-    cv::putText(m_dsp_imgResize, "Vanishing Line: " + std::to_string(m_yVanish), cv::Point(10, 540),
+    cv::putText(img, "Vanishing Line: " + std::to_string(drawResult.yVanish), cv::Point(10, 540),
                 cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 2, 0);
 
-    cv::putText(m_dsp_imgResize, "Motion (Right) = " + std::to_string(m_egoDirectionInfo.avg_xOffsetRight),
+    cv::putText(img, "Motion (Right) = " + std::to_string(drawResult.egoDirectionInfo.avg_xOffsetRight),
                 cv::Point(10, 560), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 2, 0);
 
-    cv::putText(m_dsp_imgResize, "Motion (Left) = " + std::to_string(m_egoDirectionInfo.avg_xOffsetLeft),
+    cv::putText(img, "Motion (Left) = " + std::to_string(drawResult.egoDirectionInfo.avg_xOffsetLeft),
                 cv::Point(10, 580), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 2, 0);
 
-    cv::putText(m_dsp_imgResize, "Left Line Angle = " + std::to_string(m_unscale_currLaneInfo.leftDegree),
+    cv::putText(img, "Left Line Angle = " + std::to_string(drawResult.laneInfo.leftDegree),
                 cv::Point(10, 600), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 2, 0);
 
-    cv::putText(m_dsp_imgResize, "Right Line Angle = " + std::to_string(m_unscale_currLaneInfo.rightDegree),
+    cv::putText(img, "Right Line Angle = " + std::to_string(drawResult.laneInfo.rightDegree),
                 cv::Point(10, 620), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 255, 0), 1, 2, 0);
 
-	if (m_isLaneDeparture && m_dsp_laneDeparture)
+	if (drawResult.isLaneDeparture && m_dsp_laneDeparture)
 	{
-        cv::putText(m_dsp_imgResize, "Lane Departure Warning", cv::Point(300, 50), cv::FONT_HERSHEY_COMPLEX_SMALL, 2,
+        cv::putText(img, "Lane Departure Warning", cv::Point(300, 50), cv::FONT_HERSHEY_COMPLEX_SMALL, 2,
                     cv::Scalar(0, 0, 255), 2, 5, 0);
 	}
 
-	if (m_isForwardCollision && m_dsp_forwardCollision)
+	if (drawResult.isForwardCollision && m_dsp_forwardCollision)
 	{
-        cv::putText(m_dsp_imgResize, "Forward Collision Warning", cv::Point(300, 100), cv::FONT_HERSHEY_COMPLEX_SMALL,
+        cv::putText(img, "Forward Collision Warning", cv::Point(300, 100), cv::FONT_HERSHEY_COMPLEX_SMALL,
                     2, cv::Scalar(0, 0, 255), 2, 5, 0);
 	}
 }
 
-void ADAS::_drawLaneLineMasks()
+void ADAS::_drawLaneLineMasks(ADAS_DRAW_RESULTS& drawResult)
 {
+	cv::Mat& img = drawResult.matResult;
+
 	std::vector<cv::Mat> laneMaskList;
 	std::vector<cv::Mat> lineMaskList;
 
 	for (int i = 0; i < 3; i++)
 	{
-		laneMaskList.push_back(m_laneMask);
-		lineMaskList.push_back(m_dsp_mergeLineMask);
+		laneMaskList.push_back(drawResult.matLaneMask);
+		lineMaskList.push_back(drawResult.matMergeLineMask);
 	}
 
 	cv::Mat laneMask3C;
 	cv::Mat lineMask3C;
 	const int additional_height = 160;
-	const int mask_width = m_dsp_imgResize.rows / 4;
+	const int mask_width = img.rows / 4;
 
 	cv::merge(laneMaskList, laneMask3C);
 	cv::merge(lineMaskList, lineMask3C);
 
-	cv::resize(m_dsp_colorLaneMask, m_dsp_colorLaneMask, cv::Size(mask_width, additional_height), cv::INTER_LINEAR);
+	cv::resize(drawResult.matColorLaneMask, drawResult.matColorLaneMask, cv::Size(mask_width, additional_height), cv::INTER_LINEAR);
 	cv::resize(laneMask3C, laneMask3C, cv::Size(mask_width, additional_height), cv::INTER_LINEAR);
-	cv::resize(m_dsp_colorLineMask, m_dsp_colorLineMask, cv::Size(mask_width, additional_height), cv::INTER_LINEAR);
+	cv::resize(drawResult.matColorLineMask, drawResult.matColorLineMask, cv::Size(mask_width, additional_height), cv::INTER_LINEAR);
 	cv::resize(lineMask3C, lineMask3C, cv::Size(mask_width, additional_height), cv::INTER_LINEAR);
 
 	cv::Mat dbgLaneMasks;
 	cv::Mat dbgLineMasks;
 	cv::Mat dbgMasks;
-	cv::hconcat(m_dsp_colorLaneMask, laneMask3C, dbgLaneMasks);
-	cv::hconcat(m_dsp_colorLineMask, lineMask3C, dbgLineMasks);
+	cv::hconcat(drawResult.matColorLaneMask, laneMask3C, dbgLaneMasks);
+	cv::hconcat(drawResult.matColorLineMask, lineMask3C, dbgLineMasks);
 	cv::hconcat(dbgLaneMasks, dbgLineMasks, dbgMasks);
 
-	cv::Mat imgNew = cv::Mat(cv::Size(m_dsp_imgResize.cols, m_dsp_imgResize.rows + additional_height), CV_8UC3, cv::Scalar::all(0));
+	cv::Mat imgNew = m_framePool->acquire(img.rows + additional_height, img.cols, CV_8UC3);
+	imgNew.setTo(cv::Scalar::all(0));
 
-	m_dsp_imgResize.copyTo(imgNew(cv::Rect(0, 0, m_dsp_imgResize.cols, m_dsp_imgResize.rows)));
-	dbgMasks.copyTo(imgNew(cv::Rect(0, m_dsp_imgResize.rows, dbgMasks.cols, dbgMasks.rows)));
-	m_dsp_imgResize = imgNew.clone();
+	img.copyTo(imgNew(cv::Rect(0, 0, img.cols, img.rows)));
+	dbgMasks.copyTo(imgNew(cv::Rect(0, img.rows, dbgMasks.cols, dbgMasks.rows)));
+	img = imgNew;
 }
 
-void ADAS::_drawLaneMasks()
+void ADAS::_drawLaneMasks(ADAS_DRAW_RESULTS& drawResult)
 {
-	cv::resize(m_dsp_colorLaneMask, m_dsp_colorLaneMask, m_dsp_imgResize.size(), cv::INTER_LINEAR);
-	cv::addWeighted(m_dsp_imgResize, 1.0, m_dsp_colorLaneMask, 0.5, 0.0, m_dsp_imgResize);
+	cv::Mat& img = drawResult.matResult;
+
+	cv::resize(drawResult.matColorLaneMask, drawResult.matColorLaneMask, img.size(), cv::INTER_LINEAR);
+	cv::addWeighted(img, 1.0, drawResult.matColorLaneMask, 0.5, 0.0, img);
 }
 
-void ADAS::_drawResults()
+void ADAS::_drawResults(ADAS_DRAW_RESULTS& drawResult)
 {
-	int waitKey = 1;
 	if (m_dsp_laneDeparture)
-		_drawLDWROI();
+		_drawLDWROI(drawResult);
 
 	if (m_dsp_objectDetection)
-		_drawBoundingBoxes();
+		_drawBoundingBoxes(drawResult);
 
 	if (m_dsp_objectTracking)
-		_drawTrackedObjects();
+		_drawTrackedObjects(drawResult);
 
 	if (m_dsp_laneLineDetection)
-		_drawLaneLines();
+		_drawLaneLines(drawResult);
 
-	cv::resize(m_dsp_img, m_dsp_imgResize, cv::Size(1280, 720), cv::INTER_LINEAR); // Width must be mutiplication of 4
+	drawResult.matResult = m_framePool->acquire(720, 1280, drawResult.matImage.type());
+	cv::resize(drawResult.matImage, drawResult.matResult, cv::Size(1280, 720), cv::INTER_LINEAR); // Width must be mutiplication of 4
 
 	if (m_dsp_information)
-		_drawInformation();
+		_drawInformation(drawResult);
 
 	if (m_dsp_laneLineMask)
 	{
-        if (!(m_laneMask.empty() || m_dsp_colorLaneMask.empty() || m_dsp_colorLineMask.empty()
-              || m_dsp_mergeLineMask.empty()))
-			_drawLaneLineMasks();
+        if (!(drawResult.matLaneMask.empty() || drawResult.matColorLaneMask.empty()
+              || drawResult.matColorLineMask.empty() || drawResult.matMergeLineMask.empty()))
+			_drawLaneLineMasks(drawResult);
 	}
+}
 
-	// m_drawResultBuffer.back().matResult = m_dsp_imgResize.clone();
-	#ifndef SAV837
-	if (m_dsp_results)
-		cv::imshow("WNC ADAS", m_dsp_imgResize);
-	#endif
+void ADAS::_getDrawResults(ADAS_DRAW_RESULTS& drawResult)
+{
+	drawResult.frameIdx = m_frameIdx;
+	drawResult.matRawImage = m_img;
+
+	if (!drawResult.isDraw)
+		return;
+
+	drawResult.yVanish = m_yVanish;
+	drawResult.vehicleROI = m_fcw->m_vehicleROI;
+	drawResult.riderROI = m_fcw->m_riderROI;
+	drawResult.humanROI = m_fcw->m_humanROI;
+	drawResult.xCenterAdjust = m_laneLineInfo.laneMaskInfo.xCenterAdjust;
+	drawResult.isLaneDeparture = m_isLaneDeparture;
+	drawResult.isForwardCollision = m_isForwardCollision;
+	drawResult.egoDirectionInfo = m_egoDirectionInfo;
+	drawResult.laneInfo = m_unscale_currLaneInfo;
+
+	utils::rescaleLine(
+		m_fcw->m_vehicleZone, drawResult.vehicleZone,
+		m_config->modelWidth, m_config->modelHeight,
+		m_config->frameWidth, m_config->frameHeight);
+
+	// Rescaled by _rescaleResults(), the table itself is recycled with the frame,
+	// so the snapshot owns whole boxes (source fields, rescaled coordinates)
+	const DetectionTable& table = m_rescaledDetectionTable;
+	table.copyBoxes(table.classRange(DETECT_CLASS_HUMAN), drawResult.humanBBoxList);
+	table.copyBoxes(table.classRange(DETECT_CLASS_RIDER), drawResult.riderBBoxList);
+	table.copyBoxes(table.classRange(DETECT_CLASS_VEHICLE), drawResult.vehicleBBoxList);
+	table.copyBoxes(table.classRange(DETECT_CLASS_ROAD_SIGN), drawResult.roadSignBBoxList);
+	table.copyBoxes(table.classRange(DETECT_CLASS_STOP_SIGN), drawResult.stopSignBBoxList);
+
+	drawResult.trackedObjList = m_trackedObjList;
+	drawResult.trackBBoxList = m_rescaledTrackBBoxList;
 
-	if (m_frameIdx < m_dsp_maxFrameIdx)
+	// Post-processing may reuse the mask buffers for the next prediction
+	if (m_dsp_laneLineMask)
 	{
-		waitKey = 1;
+		drawResult.matLaneMask = m_framePool->clone(m_laneMask);
+		drawResult.matMergeLineMask = m_framePool->clone(m_dsp_mergeLineMask);
+		drawResult.matColorLaneMask = m_framePool->clone(m_dsp_colorLaneMask);
+		drawResult.matColorLineMask = m_framePool->clone(m_dsp_colorLineMask);
 	}
-	else if (m_dsp_maxFrameIdx == 0)
+
+	// Input frames get a new buffer every frame, so sharing them is enough.
+	// The snapshot owns the display frame from here on, it is drawn in place.
+	drawResult.matImage = m_dsp_img;
+	m_dsp_img.release();
+}
+
+void ADAS::_submitRenderJob(bool isDraw, bool isSaveDraw, bool isSaveRaw)
+{
+	if (!isDraw && !isSaveRaw)
+		return;
+
+	if (m_renderPool == nullptr)
 	{
-		waitKey = 1;
+		ADAS_DRAW_RESULTS drawResult;
+		drawResult.isDraw = isDraw;
+		drawResult.isSaveDraw = isDraw && isSaveDraw;
+		drawResult.isSaveRaw = isSaveRaw;
+		_getDrawResults(drawResult);
+		_renderResults(drawResult);
+		return;
 	}
-	else if (m_isLaneDeparture && m_dbg_laneDeparture)
+
 	{
-		waitKey = 0;
+		std::lock_guard<std::mutex> lock(m_renderMutex);
+		m_numRenderJobs++;
+
+		// Debug output never throttles the detection loop
+		if (m_numPendingRenders >= ADAS_RENDER_QUEUE_SIZE)
+		{
+			m_numDroppedRenders++;
+			return;
+		}
+		m_numPendingRenders++;
 	}
-	else
+
+	ADAS_DRAW_RESULTS drawResult;
+	drawResult.isDraw = isDraw;
+	drawResult.isSaveDraw = isDraw && isSaveDraw;
+	drawResult.isSaveRaw = isSaveRaw;
+	_getDrawResults(drawResult);
+
+	m_renderPool->submit([this, drawResult = std::move(drawResult)]() mutable
 	{
-		waitKey = 0;
-	}
-	#ifndef SAV837
-	if (m_dsp_results)
-        cv::waitKey(1);
-	#endif
+		_renderResults(drawResult);
+
+		std::lock_guard<std::mutex> lock(m_renderMutex);
+		m_numPendingRenders--;
+	});
 }
 
-void ADAS::_showADASResult()
+void ADAS::_renderResults(ADAS_DRAW_RESULTS& drawResult)
 {
-	if (m_isDrawImage && m_drawResultBuffer.size() > 0)
+	if (drawResult.isDraw)
 	{
-		int waitKey = 1;
+		{
+			ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_DRAW);
+			_drawResults(drawResult);
+		}
 
-		cv::Mat result = m_drawResultBuffer.back().matResult;
+		// Show before encoding, imwrite takes longer than drawing
+		_pushDrawResult(drawResult);
+		if (!m_isDrawImage)
+			_showADASResult(drawResult);
+	}
 
-		#ifndef SAV837
-		if (m_dsp_results)
-			cv::imshow("WNC ADAS", m_dsp_imgResize);
-		#endif
+	ScopedStageTimer stageTimer(m_stageProfiler, ADAS_STAGE_SAVE_IMAGES);
 
-		if (m_frameIdx < m_dsp_maxFrameIdx)
-		{
-			waitKey = 1;
-		}
-		else if (m_dsp_maxFrameIdx == 0)
-		{
-			waitKey = 1;
-		}
-		else if (m_isLaneDeparture && m_dbg_laneDeparture)
+	if (drawResult.isSaveDraw)
+		_saveDrawResults(drawResult);
+
+	if (drawResult.isSaveRaw)
+		_saveRawImages(drawResult);
+}
+
+void ADAS::_pushDrawResult(const ADAS_DRAW_RESULTS& drawResult)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Render workers may finish out of order, never go back in time
+		if (drawResult.frameIdx < m_lastDrawFrameIdx)
 		{
-			waitKey = 0;
+			m_numDroppedDrawResults++;
+			return;
 		}
-		else
+		m_lastDrawFrameIdx = drawResult.frameIdx;
+		m_dsp_imgResize = drawResult.matResult;
+
+		if (!m_isDrawImage)
+			return;
+
+		// Latest frame wins, the display never falls behind the pipeline
+		while (m_drawResultBuffer.size() >= ADAS_DRAW_BUFFER_SIZE)
 		{
-			waitKey = 0;
+			m_drawResultBuffer.pop_front();
+			m_numDroppedDrawResults++;
 		}
-		#ifndef SAV837
-		cv::waitKey(1);
-		#endif
-		m_drawResultBuffer.pop_front();
+
+		// The display thread only needs the drawn frame
+		m_drawResultBuffer.emplace_back();
+		ADAS_DRAW_RESULTS& displayResult = m_drawResultBuffer.back();
+		displayResult.frameIdx = drawResult.frameIdx;
+		displayResult.yVanish = drawResult.yVanish;
+		displayResult.isLaneDeparture = drawResult.isLaneDeparture;
+		displayResult.isForwardCollision = drawResult.isForwardCollision;
+		displayResult.isDraw = false;
+		displayResult.matResult = drawResult.matResult;
 	}
+	m_condition.notify_one();
+}
+
+void ADAS::_showADASResult(const ADAS_DRAW_RESULTS& drawResult)
+{
+	int waitKey = 1;
+
+	#ifndef SAV837
+	cv::imshow("WNC ADAS", drawResult.matResult);
+	#endif
+
+	if (drawResult.frameIdx < m_dsp_maxFrameIdx)
+	{
+		waitKey = 1;
+	}
+	else if (m_dsp_maxFrameIdx == 0)
+	{
+		waitKey = 1;
+	}
+	else if (drawResult.isLaneDeparture && m_dbg_laneDeparture)
+	{
+		waitKey = 0;
+	}
+	else
+	{
+		waitKey = 0;
+	}
+	#ifndef SAV837
+	cv::waitKey(1);
+	#endif
 }
 
 // ============================================
@@ -2275,42 +2593,27 @@ bool ADAS::_runShowLogsFunc()
 
 bool ADAS::_runDrawResultFunc()
 {
-	while ((!m_threadTerminated))
+	while (true)
 	{
-		// STEP0: sleep for a while for reducing CPU loading
-		std::this_thread::sleep_for(std::chrono::microseconds(85000)); // TODO: have to find the best value
-
-    // STEP1: Start inference loop
-    std::lock_guard<std::mutex> lock(m_mutex);
+		ADAS_DRAW_RESULTS drawResult;
 
-    // if (!m_threadStarted)
-    // {
-		//   continue;
-		// }
-
-		if (m_drawResultBuffer.size() > 0)
+		// STEP0: sleep until a frame is drawn or the thread is stopped
 		{
-			// Draw and Save Results
-			if (m_dsp_results)
-			{
-				m_drawResultBuffer.back().isDraw = true;
-				_drawResults();
-				_showADASResult();
-			}
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_threadTerminated || !m_drawResultBuffer.empty(); });
 
-			if (m_dsp_results && m_dbg_saveImages)
-			{
-				_saveDrawResults();
-			}
+			if (m_threadTerminated)
+				break;
 
-			// Save Raw Images
-			if (m_dbg_saveRawImages)
-			{
-				_saveRawImages();
-			}
+			// STEP1: take the latest frame, the older ones are outdated
+			m_numDroppedDrawResults += (int)m_drawResultBuffer.size() - 1;
+			drawResult = std::move(m_drawResultBuffer.back());
+			m_drawResultBuffer.clear();
 		}
 
-		m_condition.notify_one();
+		// STEP2: show it without holding the lock
+		drawResult.isDraw = true;
+		_showADASResult(drawResult);
 	}
 
 	return true;
@@ -2321,5 +2624,61 @@ bool ADAS::_runDrawResultFunc()
 // ============================================
 void ADAS::_updateFrameIndex()
 {
+  auto m_logger = spdlog::get("ADAS");
+
+  // Recycle the scratch memory of the frame before this one
+  bool isDetectionTableUpdated = (m_detectionTableFrameIdx == m_frameIdx);
+  m_frameArena->reset();
+
+  m_logger->debug("Frame arena: {} bytes used, peak {} bytes, capacity {} bytes, {} overflows",
+                  m_frameArena->getLastFrameBytes(), m_frameArena->getPeakBytes(),
+                  m_frameArena->getCapacity(), m_frameArena->getNumOverflows());
+  m_logger->debug("Frame pool: {} hits, {} misses, {} buffers ({} bytes), {} in use, high-water mark {}",
+                  m_framePool->getNumHits(), m_framePool->getNumMisses(),
+                  m_framePool->getNumBuffers(), m_framePool->getPooledBytes(),
+                  m_framePool->getNumInUse(), m_framePool->getHighWaterMark());
+
   m_frameIdx = (m_frameIdx % 65535) + 1;
+
+  // A frame without object detection keeps the previous detections, whose
+  // tables are in the generation just recycled: rebuild them from the lists
+  if (!isDetectionTableUpdated)
+  {
+    _buildDetectionTable();
+    _rescaleResults();
+  }
+}
+
+void ADAS::_buildDetectionTable()
+{
+	// Same order as DETECT_CLASS
+	const std::vector<BoundingBox>* boundingBoxLists[DETECT_NUM_CLASSES] =
+	{
+		&m_humanBBoxList,
+		&m_riderBBoxList,
+		&m_vehicleBBoxList,
+		&m_roadSignBBoxList,
+		&m_stopSignBBoxList
+	};
+
+	m_detectionTable.build(boundingBoxLists);
+	m_detectionTableFrameIdx = m_frameIdx;
+}
+
+void ADAS::_rescaleResults()
+{
+	bboxUtil::RescaleRatio ratio = bboxUtil::getRescaleRatio(
+		m_config->modelWidth, m_config->modelHeight,
+		m_config->frameWidth, m_config->frameHeight);
+
+	m_detectionTable.rescale(ratio, m_rescaledDetectionTable);
+
+	// Last box of every tracked object, same index as m_trackedObjList
+	m_rescaledTrackBBoxList.resize(m_trackedObjList.size(), BoundingBox(-1, -1, -1, -1, -1));
+	for (int i = 0; i < m_trackedObjList.size(); i++)
+	{
+		const Object& trackedObj = m_trackedObjList[i];
+		if (!trackedObj.bboxList.empty())
+			bboxUtil::rescaleBBox(trackedObj.bboxList.back(), m_rescaledTrackBBoxList[i], ratio);
+	}
 }
@@ -17,6 +17,7 @@
 #include <deque>
 #include <thread>
 #include <condition_variable>
+#include <functional>
 
 #ifdef SAV837
 // SGS
@@ -37,6 +38,12 @@
 #include "optical_flow.hpp"
 #include "object_tracker.hpp"
 #include "json_log.hpp"
+#include "detection_table.hpp"
+#include "frame_arena.hpp"
+#include "frame_pool.hpp"
+#include "worker_pool.hpp"
+#include "stage_graph.hpp"
+#include "stage_profiler.hpp"
 #ifdef QCS6490
 #include "ldw.hpp"
 #include "fcw.hpp"
@@ -49,10 +56,85 @@
 
 using namespace std;
 
+class JSON_LOG;
+
 #define ADAS_VERSION "0.4.1"
 #define ADAS_SUCCESS 1
 #define ADAS_FAILURE 0
 
+// Worker threads of the stage graph, besides the caller thread (0 = serial)
+#ifndef ADAS_NUM_STAGE_WORKERS
+#ifdef QCS6490
+#define ADAS_NUM_STAGE_WORKERS 1
+#else
+#define ADAS_NUM_STAGE_WORKERS 0
+#endif
+#endif
+
+// Run the human, rider and vehicle trackers concurrently on the stage workers.
+// Off until ObjectTracker is shown not to write the shared FCW data buffer
+// and adas_replay_bench --check-tracking passes on target.
+#ifndef ADAS_PARALLEL_TRACKING
+#define ADAS_PARALLEL_TRACKING 0
+#endif
+
+// Render workers for drawing and saving debug images (0 = on the ADAS thread)
+#ifndef ADAS_NUM_RENDER_WORKERS
+#ifdef QCS6490
+#define ADAS_NUM_RENDER_WORKERS 2
+#else
+#define ADAS_NUM_RENDER_WORKERS 0
+#endif
+#endif
+
+// Frames queued or being rendered, newer frames are dropped when full
+#ifndef ADAS_RENDER_QUEUE_SIZE
+#define ADAS_RENDER_QUEUE_SIZE 4
+#endif
+
+// Drawn frames waiting for the display thread, the oldest is dropped when full
+#ifndef ADAS_DRAW_BUFFER_SIZE
+#define ADAS_DRAW_BUFFER_SIZE 2
+#endif
+
+// With saveLogs, the JSON log keeps only the frames around LDW / FCW events
+// (black box mode) instead of every frame
+#ifndef ADAS_JSON_LOG_BLACK_BOX
+#define ADAS_JSON_LOG_BLACK_BOX 0
+#endif
+
+// Black box window: frames before an event and after the last one
+#ifndef ADAS_BLACK_BOX_PRE_FRAMES
+#define ADAS_BLACK_BOX_PRE_FRAMES 150
+#endif
+
+#ifndef ADAS_BLACK_BOX_POST_FRAMES
+#define ADAS_BLACK_BOX_POST_FRAMES 90
+#endif
+
+// With saveLogs, tracked objects go to a delta coded <log>.trk stream instead
+// of the trackObj entries of the JSON log
+#ifndef ADAS_JSON_LOG_TRACK_STREAM
+#define ADAS_JSON_LOG_TRACK_STREAM 0
+#endif
+
+// Stages timed by m_stageProfiler
+enum ADAS_STAGES
+{
+  ADAS_STAGE_FRAME,
+  ADAS_STAGE_EGO_DIRECTION,
+  ADAS_STAGE_LANE_LINE_MASKS,
+  ADAS_STAGE_LANE_LINE_DETECTION,
+  ADAS_STAGE_OBJECT_DETECTION,
+  ADAS_STAGE_OBJECT_TRACKING,
+  ADAS_STAGE_LANE_DEPARTURE,
+  ADAS_STAGE_FORWARD_COLLISION,
+  ADAS_STAGE_DRAW,
+  ADAS_STAGE_SAVE_IMAGES,
+  ADAS_STAGE_JSON_LOG,
+  ADAS_NUM_STAGES
+};
+
 enum ADAS_EVENTS
 {
   ADAS_EVENT_NORMAL,
@@ -62,26 +144,38 @@ enum ADAS_EVENTS
 };
 
 
+// Snapshot of one frame for drawing and saving, filled by _getDrawResults().
+// Render workers only touch their own snapshot, never the ADAS members.
 struct ADAS_DRAW_RESULTS
 {
-	int yVanish;
+	int frameIdx = 0;
+	int yVanish = 0;
   	ROI vehicleROI;
 	ROI riderROI;
 	ROI humanROI;
-	bool isLaneDeparture;
-	bool isForwardCollision;
-	bool isDraw;
-	std::vector<BoundingBox> humanBBoxList;
+	ROI vehicleZone;            // Frame size
+	float xCenterAdjust = 0;
+	bool isLaneDeparture = false;
+	bool isForwardCollision = false;
+	bool isDraw = false;
+	bool isSaveDraw = false;
+	bool isSaveRaw = false;
+	DirectionInfo egoDirectionInfo;
+	LaneInfo laneInfo;
+	std::vector<BoundingBox> humanBBoxList;     // Frame size
 	std::vector<BoundingBox> riderBBoxList;
 	std::vector<BoundingBox> vehicleBBoxList;
 	std::vector<BoundingBox> roadSignBBoxList;
 	std::vector<BoundingBox> stopSignBBoxList;
 	std::vector<Object> trackedObjList;
+	std::vector<BoundingBox> trackBBoxList;     // Frame size, one per tracked object
 	cv::Mat matCalibMask;
 	cv::Mat matLaneMask;
 	cv::Mat matMergeLineMask;
 	cv::Mat matColorLaneMask;
 	cv::Mat matColorLineMask;
+	cv::Mat matImage;           // Display frame, drawn in place
+	cv::Mat matRawImage;        // Model input frame
 	cv::Mat matResult;
 };
 
@@ -126,6 +220,7 @@ class ADAS
 		bool _laneLineDetection();
 		bool _objectDetection();
 		bool _objectTracking();
+		void _runTrackersParallel();
 		bool _laneDepartureDetection();
 		bool _forwardCollisionDetection();
 		
@@ -135,20 +230,44 @@ class ADAS
 		float getFollowingDistance();
 		void getResults(ADAS_Results &result);
 		void getResultImage(cv::Mat &imgResult);
+		void getTrackedObjects(std::vector<Object> &objList);
+
+		// === Tracking === //
+		void setParallelTracking(bool enable);  // Default ADAS_PARALLEL_TRACKING
+
+		// === Profiling === //
+		void showStageLatency();                            // p50/p95/p99 per stage
+		bool saveStageTrace(const std::string& tracePath);  // Chrome trace-event JSON
+		void showMemoryUsage();                             // Frame arena and pool high-water marks
+
+		#ifdef QCS6490
+		// === Replay === //
+		// Offline replay without the NPU: func fills the post-processing result
+		// of each processed frame (boxes in model size) in place of YOLO-ADAS
+		void setReplaySource(std::function<bool(POST_PROC_RESULTS& result)> func);
+		#endif
 
 		// === Utils === //
 		void _updateFrameIndex();
+		void _buildDetectionTable();
+		void _rescaleResults();
 
 		// === Results === //
-		void _saveRawImages();
+		void _saveRawImages(const ADAS_DRAW_RESULTS& drawResult);
 		void _showDetectionResults();
 		void _saveDetectionResults();
-		void _saveDrawResults();
-		void _showADASResult();
+		void _saveDrawResults(const ADAS_DRAW_RESULTS& drawResult);
+		void _showADASResult(const ADAS_DRAW_RESULTS& drawResult);
+		void _pushDrawResult(const ADAS_DRAW_RESULTS& drawResult);
+
+		// === Render === //
+		void _getDrawResults(ADAS_DRAW_RESULTS& drawResult);
+		void _submitRenderJob(bool isDraw, bool isSaveDraw, bool isSaveRaw);
+		void _renderResults(ADAS_DRAW_RESULTS& drawResult);
 
 		// === Debug === //
-		void _drawResults();
-		void _drawLDWROI();
+		void _drawResults(ADAS_DRAW_RESULTS& drawResult);
+		void _drawLDWROI(ADAS_DRAW_RESULTS& drawResult);
 				
 		// === YOLO-ADAS === //
 		OpticalFlow* m_opticalFlow;
@@ -158,6 +277,7 @@ class ADAS
 
 		// === Post Processing Result (for Multi-Thread) === //
 		POST_PROC_RESULTS m_procResult;
+		std::function<bool(POST_PROC_RESULTS& result)> m_replayResultFunc;  // See setReplaySource
 
 	protected:
 
@@ -209,21 +329,27 @@ class ADAS
 		bool _readDebugConfig();
 		bool _readDisplayConfig();
 		bool _readShowProcTimeConfig();
+		bool _initJsonLog();
+		bool _initStageGraph();
     	void _saveDetectionResult(std::vector<std::string>& logs);
 
+		// === Work Flow === //
+		bool _runStage(bool (ADAS::*stageFunc)(), const char* failMessage);
+		void _getInputFrame(const cv::Mat& imgFrame, cv::Mat& imgOut, int width, int height);
+
 		// === Thread Management === //
 		bool _runShowLogsFunc();
 		bool _runDrawResultFunc();
 
 		// === Debug === //
 		void _drawLaneDetector();
-		void _drawBoundingBoxes();
-		void _drawTrackedObjects();
-		void _drawLaneLines();
+		void _drawBoundingBoxes(ADAS_DRAW_RESULTS& drawResult);
+		void _drawTrackedObjects(ADAS_DRAW_RESULTS& drawResult);
+		void _drawLaneLines(ADAS_DRAW_RESULTS& drawResult);
 		void _drawCrossWalk();
-		void _drawInformation();
-		void _drawLaneLineMasks();
-		void _drawLaneMasks();
+		void _drawInformation(ADAS_DRAW_RESULTS& drawResult);
+		void _drawLaneLineMasks(ADAS_DRAW_RESULTS& drawResult);
+		void _drawLaneMasks(ADAS_DRAW_RESULTS& drawResult);
 
 
 		// === Config === //
@@ -292,6 +418,18 @@ class ADAS
 		std::vector<BoundingBox> m_f_stopSignBBoxList;
 		std::vector<BoundingBox> m_f_roadSignBBoxList;
 
+		// All detections of the frame, one class range per list above (_objectDetection)
+		DetectionTable m_detectionTable;
+		int m_detectionTableFrameIdx = -1;   // Frame that built m_detectionTable
+
+		// Whole source boxes for the APIs that take std::vector (optical flow, debug logger)
+		std::vector<BoundingBox> m_detectBBoxList;
+
+		// Rescaled to frame size once per frame (_rescaleResults),
+		// shared by the drawers and the JSON log
+		DetectionTable m_rescaledDetectionTable;
+		std::vector<BoundingBox> m_rescaledTrackBBoxList;  // Last box of each m_trackedObjList entry
+
 		// === Objects === //
 		std::vector<Object> m_humanObjList;
 		std::vector<Object> m_riderObjList;
@@ -303,6 +441,10 @@ class ADAS
 		ObjectTracker* m_riderTracker;
 		ObjectTracker* m_vehicleTracker;
 
+		// Parallel tracking: the trackers run concurrently on the stage workers,
+		// all of them reading the one FCW data buffer
+		bool m_parallelTracking = false;
+
 		// === Optical Flow === //
 		cv::Mat m_flow;
 		DirectionInfo m_egoDirectionInfo;
@@ -343,16 +485,42 @@ class ADAS
 
 		// === Result === //
 		ADAS_Results m_result;
-		std::deque<ADAS_DRAW_RESULTS> m_drawResultBuffer;
+		std::deque<ADAS_DRAW_RESULTS> m_drawResultBuffer; // Guarded by m_mutex
+		int m_numDroppedDrawResults = 0;                  // Frames never shown
+		int m_lastDrawFrameIdx = -1;
+
+		// === Render === //
+		// Drawing and image saving on frame snapshots, see _submitRenderJob
+		WorkerPool* m_renderPool = nullptr;  // nullptr renders on the ADAS thread
+		std::mutex m_renderMutex;
+		int m_numPendingRenders = 0;
+		int m_numRenderJobs = 0;
+		int m_numDroppedRenders = 0;
+
+		// === JSON Log === //
+		JSON_LOG* m_jsonLog;
+
+		// === Stage Graph === //
+		// Lane lines -> objects -> (LDW || tracking -> FCW), see _initStageGraph
+		WorkerPool* m_workerPool;
+		StageGraph* m_stageGraph;
+
+		// === Frame Memory === //
+		// Scratch data of the frame (detection tables), recycled by _updateFrameIndex
+		FrameArena* m_frameArena;
+		// Frame sized cv::Mat buffers, back to the pool with their last reference
+		FramePool* m_framePool;
+
+		// === Profiling === //
+		StageProfiler* m_stageProfiler;
 
 
 		// === Display === //
 		cv::Mat m_dsp_img;
-		cv::Mat m_dsp_imgResize;
+		cv::Mat m_dsp_imgResize;  // Latest rendered frame, guarded by m_mutex
 		cv::Mat m_dsp_colorLaneMask;
 		cv::Mat m_dsp_colorLineMask;
 		cv::Mat m_dsp_calibMask; //TODO:
-		cv::Mat m_dsp_laneLineResult;
 		cv::Mat m_dsp_mergeLineMask; //TODO:
 		
 		bool m_dsp_laneLineMask = false;
@@ -0,0 +1,127 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "bbox_rescale.hpp"
+
+static_assert(std::is_same<decltype(BoundingBox::x1), int>::value &&
+			  std::is_same<decltype(BoundingBox::y2), int>::value,
+			  "bboxUtil assumes int box coordinates");
+
+namespace bboxUtil
+{
+	RescaleRatio getRescaleRatio(int modelWidth, int modelHeight, int frameWidth, int frameHeight)
+	{
+		RescaleRatio ratio;
+		ratio.width = (float)modelWidth / (float)frameWidth;
+		ratio.height = (float)modelHeight / (float)frameHeight;
+		return ratio;
+	}
+
+	// One box: {x1, y1, x2, y2} / {w, h, w, h}
+	static inline void rescaleQuad(const int* in, int* out, const RescaleRatio& ratio)
+	{
+	#if defined(__SSE2__)
+		const __m128 divisor = _mm_setr_ps(ratio.width, ratio.height, ratio.width, ratio.height);
+		__m128 coords = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)in));
+		_mm_storeu_si128((__m128i*)out, _mm_cvttps_epi32(_mm_div_ps(coords, divisor)));
+	#elif defined(__aarch64__) && defined(__ARM_NEON)
+		const float divisorData[4] = {ratio.width, ratio.height, ratio.width, ratio.height};
+		float32x4_t coords = vcvtq_f32_s32(vld1q_s32(in));
+		vst1q_s32(out, vcvtq_s32_f32(vdivq_f32(coords, vld1q_f32(divisorData))));
+	#else
+		out[0] = (int)((float)in[0] / ratio.width);
+		out[1] = (int)((float)in[1] / ratio.height);
+		out[2] = (int)((float)in[2] / ratio.width);
+		out[3] = (int)((float)in[3] / ratio.height);
+	#endif
+	}
+
+	void rescaleCoords(const int* in, int* out, size_t numBoxes, const RescaleRatio& ratio)
+	{
+		size_t i = 0;
+
+	#if defined(__AVX2__)
+		// Two boxes per iteration
+		const __m256 divisor = _mm256_setr_ps(ratio.width, ratio.height, ratio.width, ratio.height,
+											  ratio.width, ratio.height, ratio.width, ratio.height);
+		for (; i + 2 <= numBoxes; i += 2)
+		{
+			__m256 coords = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in + 4 * i)));
+			_mm256_storeu_si256((__m256i*)(out + 4 * i), _mm256_cvttps_epi32(_mm256_div_ps(coords, divisor)));
+		}
+	#endif
+
+		for (; i < numBoxes; i++)
+			rescaleQuad(in + 4 * i, out + 4 * i, ratio);
+	}
+
+	void rescaleColumn(const int* in, int* out, size_t numValues, float ratio)
+	{
+		size_t i = 0;
+
+	#if defined(__AVX2__)
+		const __m256 divisor8 = _mm256_set1_ps(ratio);
+		for (; i + 8 <= numValues; i += 8)
+		{
+			__m256 values = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in + i)));
+			_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvttps_epi32(_mm256_div_ps(values, divisor8)));
+		}
+	#endif
+
+	#if defined(__SSE2__)
+		const __m128 divisor4 = _mm_set1_ps(ratio);
+		for (; i + 4 <= numValues; i += 4)
+		{
+			__m128 values = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in + i)));
+			_mm_storeu_si128((__m128i*)(out + i), _mm_cvttps_epi32(_mm_div_ps(values, divisor4)));
+		}
+	#elif defined(__aarch64__) && defined(__ARM_NEON)
+		const float32x4_t divisor4 = vdupq_n_f32(ratio);
+		for (; i + 4 <= numValues; i += 4)
+			vst1q_s32(out + i, vcvtq_s32_f32(vdivq_f32(vcvtq_f32_s32(vld1q_s32(in + i)), divisor4)));
+	#endif
+
+		for (; i < numValues; i++)
+			out[i] = (int)((float)in[i] / ratio);
+	}
+
+	void rescaleBBox(const BoundingBox& in, BoundingBox& out, const RescaleRatio& ratio)
+	{
+		int coords[4] = {in.x1, in.y1, in.x2, in.y2};
+		rescaleQuad(coords, coords, ratio);
+
+		out = in;
+		out.x1 = coords[0];
+		out.y1 = coords[1];
+		out.x2 = coords[2];
+		out.y2 = coords[3];
+	}
+
+	void rescaleBBoxList(const std::vector<BoundingBox>& in, std::vector<BoundingBox>& out,
+						 const RescaleRatio& ratio)
+	{
+		out.assign(in.begin(), in.end());
+		for (size_t i = 0; i < out.size(); i++)
+			rescaleBBox(out[i], out[i], ratio);
+	}
+};
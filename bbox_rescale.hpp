@@ -0,0 +1,52 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __BBOX_RESCALE__
+#define __BBOX_RESCALE__
+
+#include <cstddef>
+#include <vector>
+
+#include "bounding_box.hpp"
+
+// Batch model -> frame rescaling of bounding boxes.
+//
+// Same arithmetic as utils::rescaleBBox: every coordinate is divided in float
+// by (model size / frame size) and truncated toward zero. The four coordinates
+// of a box go through one SIMD division (SSE2 / AVX2 on x86, NEON on AArch64),
+// other targets use the scalar path.
+namespace bboxUtil
+{
+	struct RescaleRatio
+	{
+		float width = 1.0f;    // modelWidth / frameWidth
+		float height = 1.0f;   // modelHeight / frameHeight
+	};
+
+	RescaleRatio getRescaleRatio(int modelWidth, int modelHeight, int frameWidth, int frameHeight);
+
+	// Contiguous x1, y1, x2, y2 quadruples, in and out may be the same buffer
+	void rescaleCoords(const int* in, int* out, size_t numBoxes, const RescaleRatio& ratio);
+
+	// One coordinate column (structure of arrays), in and out may be the same buffer
+	void rescaleColumn(const int* in, int* out, size_t numValues, float ratio);
+
+	// Other members (label, confidence, ids) are copied unchanged
+	void rescaleBBox(const BoundingBox& in, BoundingBox& out, const RescaleRatio& ratio);
+
+	// out keeps its capacity, so a per-frame cache does not reallocate
+	void rescaleBBoxList(const std::vector<BoundingBox>& in, std::vector<BoundingBox>& out,
+						 const RescaleRatio& ratio);
+};
+
+#endif
@@ -0,0 +1,203 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include <algorithm>
+
+#include "detection_table.hpp"
+
+// Column starts are kept 32 bytes apart (8 values) for the SIMD rescale
+#define DETECTION_TABLE_COLUMN_ALIGN 32
+#define DETECTION_TABLE_NUM_COLUMNS 7
+
+DetectionTable::DetectionTable(std::pmr::memory_resource* resource)
+	: m_resource(resource)
+{
+}
+
+DetectionTable::~DetectionTable()
+{
+	_releaseBlock();
+}
+
+void DetectionTable::setMemoryResource(std::pmr::memory_resource* resource)
+{
+	_releaseBlock();
+	m_resource = resource;
+	m_size = 0;
+	std::fill(m_classBegin, m_classBegin + DETECT_NUM_CLASSES + 1, 0);
+	std::fill(m_sourceLists, m_sourceLists + DETECT_NUM_CLASSES, nullptr);
+}
+
+void DetectionTable::clear()
+{
+	if (m_resource != std::pmr::new_delete_resource())
+		_releaseBlock();
+	m_size = 0;
+	std::fill(m_classBegin, m_classBegin + DETECT_NUM_CLASSES + 1, 0);
+	std::fill(m_sourceLists, m_sourceLists + DETECT_NUM_CLASSES, nullptr);
+}
+
+void DetectionTable::_releaseBlock()
+{
+	// Frame scoped blocks are released with their arena
+	if (m_block != nullptr && m_resource == std::pmr::new_delete_resource())
+		m_resource->deallocate(m_block, m_blockSize, DETECTION_TABLE_COLUMN_ALIGN);
+
+	m_block = nullptr;
+	m_blockSize = 0;
+	m_capacity = 0;
+	m_x1 = m_y1 = m_x2 = m_y2 = m_label = m_classIdx = nullptr;
+	m_confidence = nullptr;
+}
+
+void DetectionTable::_resize(size_t numBoxes)
+{
+	bool isReusable = (m_resource == std::pmr::new_delete_resource() && numBoxes <= m_capacity);
+
+	if (!isReusable)
+	{
+		_releaseBlock();
+
+		const size_t valuesPerColumn = DETECTION_TABLE_COLUMN_ALIGN / sizeof(int);
+		size_t capacity = (numBoxes + valuesPerColumn - 1) / valuesPerColumn * valuesPerColumn;
+		if (capacity == 0)
+			capacity = valuesPerColumn;
+
+		m_blockSize = capacity * sizeof(int) * DETECTION_TABLE_NUM_COLUMNS;
+		m_block = m_resource->allocate(m_blockSize, DETECTION_TABLE_COLUMN_ALIGN);
+		m_capacity = capacity;
+
+		int* column = (int*)m_block;
+		m_x1 = column;
+		m_y1 = column + capacity;
+		m_x2 = column + capacity * 2;
+		m_y2 = column + capacity * 3;
+		m_label = column + capacity * 4;
+		m_classIdx = column + capacity * 5;
+		m_confidence = (float*)(column + capacity * 6);
+	}
+
+	m_size = numBoxes;
+}
+
+void DetectionTable::build(const std::vector<BoundingBox>* const classLists[])
+{
+	size_t numBoxes = 0;
+	for (int j = 0; j < DETECT_NUM_CLASSES; j++)
+	{
+		m_classBegin[j] = numBoxes;
+		numBoxes += classLists[j]->size();
+	}
+	m_classBegin[DETECT_NUM_CLASSES] = numBoxes;
+	std::copy(classLists, classLists + DETECT_NUM_CLASSES, m_sourceLists);
+
+	_resize(numBoxes);
+
+	size_t row = 0;
+	for (int j = 0; j < DETECT_NUM_CLASSES; j++)
+	{
+		const std::vector<BoundingBox>& bboxList = *classLists[j];
+
+		for (size_t i = 0; i < bboxList.size(); i++, row++)
+		{
+			const BoundingBox& box = bboxList[i];
+			m_x1[row] = box.x1;
+			m_y1[row] = box.y1;
+			m_x2[row] = box.x2;
+			m_y2[row] = box.y2;
+			m_confidence[row] = box.confidence;
+			m_label[row] = box.label;
+			m_classIdx[row] = j;
+		}
+	}
+}
+
+void DetectionTable::rescale(const bboxUtil::RescaleRatio& ratio, DetectionTable& out) const
+{
+	const size_t numBoxes = size();
+
+	out._resize(numBoxes);
+	std::copy(m_classBegin, m_classBegin + DETECT_NUM_CLASSES + 1, out.m_classBegin);
+	std::copy(m_sourceLists, m_sourceLists + DETECT_NUM_CLASSES, out.m_sourceLists);
+
+	bboxUtil::rescaleColumn(m_x1, out.m_x1, numBoxes, ratio.width);
+	bboxUtil::rescaleColumn(m_y1, out.m_y1, numBoxes, ratio.height);
+	bboxUtil::rescaleColumn(m_x2, out.m_x2, numBoxes, ratio.width);
+	bboxUtil::rescaleColumn(m_y2, out.m_y2, numBoxes, ratio.height);
+
+	std::copy(m_confidence, m_confidence + numBoxes, out.m_confidence);
+	std::copy(m_label, m_label + numBoxes, out.m_label);
+	std::copy(m_classIdx, m_classIdx + numBoxes, out.m_classIdx);
+}
+
+DetectionRange DetectionTable::all() const
+{
+	DetectionRange range;
+	range.begin = 0;
+	range.end = size();
+	return range;
+}
+
+DetectionRange DetectionTable::classRange(int classIdx) const
+{
+	return classRange(classIdx, classIdx);
+}
+
+DetectionRange DetectionTable::classRange(int firstClassIdx, int lastClassIdx) const
+{
+	DetectionRange range;
+	if (firstClassIdx < 0 || lastClassIdx >= DETECT_NUM_CLASSES || firstClassIdx > lastClassIdx)
+		return range;
+
+	range.begin = m_classBegin[firstClassIdx];
+	range.end = m_classBegin[lastClassIdx + 1];
+	return range;
+}
+
+DetectionColumns DetectionTable::columns(const DetectionRange& range) const
+{
+	DetectionColumns view;
+	view.x1 = m_x1 + range.begin;
+	view.y1 = m_y1 + range.begin;
+	view.x2 = m_x2 + range.begin;
+	view.y2 = m_y2 + range.begin;
+	view.confidence = m_confidence + range.begin;
+	view.label = m_label + range.begin;
+	view.classIdx = m_classIdx + range.begin;
+	view.size = range.size();
+	return view;
+}
+
+const BoundingBox& DetectionTable::getSourceBox(size_t row) const
+{
+	int classIdx = m_classIdx[row];
+	return (*m_sourceLists[classIdx])[row - m_classBegin[classIdx]];
+}
+
+BoundingBox DetectionTable::getBox(size_t row) const
+{
+	// objID, boxID and the rest come with the source box
+	BoundingBox box = getSourceBox(row);
+	box.x1 = m_x1[row];
+	box.y1 = m_y1[row];
+	box.x2 = m_x2[row];
+	box.y2 = m_y2[row];
+	return box;
+}
+
+void DetectionTable::copyBoxes(const DetectionRange& range, std::vector<BoundingBox>& out) const
+{
+	out.clear();
+	for (size_t row = range.begin; row < range.end; row++)
+		out.push_back(getBox(row));
+}
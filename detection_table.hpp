@@ -0,0 +1,142 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __DETECTION_TABLE__
+#define __DETECTION_TABLE__
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "bounding_box.hpp"
+#include "bbox_rescale.hpp"
+
+// Detected object classes, in the order of the class ranges of a DetectionTable
+enum DETECT_CLASS
+{
+	DETECT_CLASS_HUMAN = 0,
+	DETECT_CLASS_RIDER,
+	DETECT_CLASS_VEHICLE,
+	DETECT_CLASS_ROAD_SIGN,
+	DETECT_CLASS_STOP_SIGN,
+	DETECT_NUM_CLASSES
+};
+
+// Rows [begin, end) of a DetectionTable
+struct DetectionRange
+{
+	size_t begin = 0;
+	size_t end = 0;
+
+	size_t size() const { return end - begin; }
+	bool empty() const { return end == begin; }
+};
+
+// Columns of a row range, read in place: x1[i] is the x1 of row range.begin + i
+struct DetectionColumns
+{
+	const int* x1 = nullptr;
+	const int* y1 = nullptr;
+	const int* x2 = nullptr;
+	const int* y2 = nullptr;
+	const float* confidence = nullptr;
+	const int* label = nullptr;
+	const int* classIdx = nullptr;
+	size_t size = 0;
+};
+
+// Detections of one frame as a structure of arrays.
+//
+// Every column holds one value per box, the boxes of a class are stored
+// contiguously and in DETECT_CLASS order, so a class (or a run of classes such
+// as human..vehicle) is a plain row range. The table is built once per frame
+// and read in place.
+//
+// All columns live in one block. On the default heap resource the block is
+// kept and reused while it is large enough. Any other resource is taken as
+// frame scoped (FrameArena): every build takes a fresh block and blocks are
+// never handed back, they go away with the arena.
+//
+// Each row remembers the box it was built from (class list and position), the
+// lists passed to build() must outlive the reads of the table.
+class DetectionTable
+{
+public:
+	explicit DetectionTable(std::pmr::memory_resource* resource = std::pmr::new_delete_resource());
+	~DetectionTable();
+
+	DetectionTable(const DetectionTable&) = delete;
+	DetectionTable& operator=(const DetectionTable&) = delete;
+
+	void setMemoryResource(std::pmr::memory_resource* resource);
+
+	void clear();
+
+	// classLists[DETECT_NUM_CLASSES], in DETECT_CLASS order
+	void build(const std::vector<BoundingBox>* const classLists[]);
+
+	// Same boxes divided by the model / frame ratio, see bboxUtil
+	void rescale(const bboxUtil::RescaleRatio& ratio, DetectionTable& out) const;
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	DetectionRange all() const;
+	DetectionRange classRange(int classIdx) const;
+	DetectionRange classRange(int firstClassIdx, int lastClassIdx) const;  // Both included
+
+	// Columns
+	const int* x1() const { return m_x1; }
+	const int* y1() const { return m_y1; }
+	const int* x2() const { return m_x2; }
+	const int* y2() const { return m_y2; }
+	const float* confidence() const { return m_confidence; }
+	const int* label() const { return m_label; }
+	const int* classIdx() const { return m_classIdx; }
+
+	// Column view of a range
+	DetectionColumns columns(const DetectionRange& range) const;
+
+	// Box the row was built from, every field as it was (not rescaled)
+	const BoundingBox& getSourceBox(size_t row) const;
+
+	// Row as a BoundingBox: the whole source box with the coordinates of
+	// this table (rescaled ones for a rescaled table)
+	BoundingBox getBox(size_t row) const;
+
+	// For APIs that take std::vector<BoundingBox>, out keeps its capacity
+	void copyBoxes(const DetectionRange& range, std::vector<BoundingBox>& out) const;
+
+private:
+	void _resize(size_t numBoxes);
+	void _releaseBlock();
+
+	std::pmr::memory_resource* m_resource;
+	void* m_block = nullptr;
+	size_t m_blockSize = 0;
+	size_t m_capacity = 0;
+	size_t m_size = 0;
+
+	int* m_x1 = nullptr;
+	int* m_y1 = nullptr;
+	int* m_x2 = nullptr;
+	int* m_y2 = nullptr;
+	float* m_confidence = nullptr;
+	int* m_label = nullptr;
+	int* m_classIdx = nullptr;
+
+	size_t m_classBegin[DETECT_NUM_CLASSES + 1] = {0};
+	const std::vector<BoundingBox>* m_sourceLists[DETECT_NUM_CLASSES] = {nullptr};
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include "frame_arena.hpp"
+
+FrameArena::FrameArena(size_t initialSize)
+{
+	_initGeneration(m_generations[0], initialSize);
+	_initGeneration(m_generations[1], initialSize);
+}
+
+FrameArena::~FrameArena()
+{
+	_freeGeneration(m_generations[0]);
+	_freeGeneration(m_generations[1]);
+}
+
+void FrameArena::_initGeneration(Generation& gen, size_t capacity)
+{
+	gen.buffer = new unsigned char[capacity];
+	gen.capacity = capacity;
+	gen.bytesUsed = 0;
+
+	// Overflow goes to the heap through the upstream resource
+	gen.resource = new std::pmr::monotonic_buffer_resource(
+		gen.buffer, capacity, std::pmr::new_delete_resource());
+}
+
+void FrameArena::_freeGeneration(Generation& gen)
+{
+	delete gen.resource;
+	delete[] gen.buffer;
+
+	gen.resource = nullptr;
+	gen.buffer = nullptr;
+	gen.capacity = 0;
+	gen.bytesUsed = 0;
+}
+
+void FrameArena::reset()
+{
+	Generation& done = m_generations[m_current];
+
+	m_lastFrameBytes = done.bytesUsed;
+	if (m_lastFrameBytes > m_peakBytes)
+		m_peakBytes = m_lastFrameBytes;
+	if (done.bytesUsed > done.capacity)
+		m_numOverflows++;
+
+	// Recycle the generation of the frame before, enlarged if the peak no
+	// longer fits (alignment padding is not counted, keep some headroom)
+	m_current ^= 1;
+	Generation& next = m_generations[m_current];
+
+	size_t needed = m_peakBytes + m_peakBytes / 4;
+	if (needed > next.capacity)
+	{
+		_freeGeneration(next);
+		_initGeneration(next, needed);
+	}
+	else
+	{
+		next.resource->release();
+		next.bytesUsed = 0;
+	}
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+	Generation& gen = m_generations[m_current];
+	gen.bytesUsed += bytes;
+	return gen.resource->allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/)
+{
+	// Released with the whole generation by reset()
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
@@ -0,0 +1,83 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __FRAME_ARENA__
+#define __FRAME_ARENA__
+
+#include <cstddef>
+#include <memory_resource>
+
+// Initial size of each arena generation, grown at reset() when a frame spills
+#define FRAME_ARENA_DEFAULT_SIZE (256 * 1024)
+
+// Frame-scoped monotonic allocator for per-frame scratch data.
+//
+// Allocation is a pointer bump, deallocate() does nothing, and everything is
+// released at once by reset() at the end of the frame. Two generations are
+// kept: reset() recycles the generation of the frame before, so data of
+// frame k stays valid until the end of frame k+1 (ego direction reads the
+// detections of the previous frame, the JSON log is written after the
+// frame index moved on).
+//
+// A frame larger than the generation spills to the heap; the generation is
+// then enlarged to the peak on its next reset, so a steady stream of frames
+// settles to zero heap allocations.
+//
+// Not thread safe: one stage allocates at a time. Stages that allocate are
+// ordered by their StageGraph dependencies (the detection table is built by
+// the ObjectDetection stage on a WorkerPool thread, rescaled after the graph
+// ran), reset() runs on the frame loop thread once the frame is done.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	explicit FrameArena(size_t initialSize = FRAME_ARENA_DEFAULT_SIZE);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// End of frame: record the usage and start the next frame
+	void reset();
+
+	size_t getBytesUsed() const { return m_generations[m_current].bytesUsed; }  // Current frame
+	size_t getLastFrameBytes() const { return m_lastFrameBytes; }
+	size_t getPeakBytes() const { return m_peakBytes; }
+	size_t getCapacity() const { return m_generations[m_current].capacity; }
+	int getNumOverflows() const { return m_numOverflows; }   // Frames that spilled to the heap
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	struct Generation
+	{
+		unsigned char* buffer = nullptr;
+		size_t capacity = 0;
+		size_t bytesUsed = 0;
+		std::pmr::monotonic_buffer_resource* resource = nullptr;
+	};
+
+	void _initGeneration(Generation& gen, size_t capacity);
+	void _freeGeneration(Generation& gen);
+
+	Generation m_generations[2];
+	int m_current = 0;
+
+	size_t m_lastFrameBytes = 0;
+	size_t m_peakBytes = 0;
+	int m_numOverflows = 0;
+};
+
+#endif
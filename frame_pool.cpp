@@ -0,0 +1,157 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include "frame_pool.hpp"
+
+FramePool::FramePool(int maxBuffersPerKey)
+	: m_maxBuffersPerKey(maxBuffersPerKey)
+{
+}
+
+void FramePool::reserve(int rows, int cols, int type, int numBuffers)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	int numOfKey = 0;
+	for (int i = 0; i < m_slots.size(); i++)
+	{
+		const Slot& slot = m_slots[i];
+		if (slot.rows == rows && slot.cols == cols && slot.type == type)
+			numOfKey++;
+	}
+
+	for (; numOfKey < numBuffers && numOfKey < m_maxBuffersPerKey; numOfKey++)
+	{
+		Slot slot;
+		slot.rows = rows;
+		slot.cols = cols;
+		slot.type = type;
+		slot.buffer = cv::Mat(rows, cols, type);
+		m_pooledBytes += slot.buffer.total() * slot.buffer.elemSize();
+		m_slots.push_back(slot);
+	}
+}
+
+cv::Mat FramePool::acquire(int rows, int cols, int type)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	int numOfKey = 0;
+	for (int i = 0; i < m_slots.size(); i++)
+	{
+		const Slot& slot = m_slots[i];
+		if (slot.rows != rows || slot.cols != cols || slot.type != type)
+			continue;
+
+		numOfKey++;
+		if (_isFree(slot.buffer))
+		{
+			cv::Mat buffer = slot.buffer;
+			m_numHits++;
+			_updateHighWaterMark();
+			return buffer;
+		}
+	}
+
+	m_numMisses++;
+
+	// Pool of this key is full, the buffer is freed with its last Mat
+	if (numOfKey >= m_maxBuffersPerKey)
+		return cv::Mat(rows, cols, type);
+
+	Slot slot;
+	slot.rows = rows;
+	slot.cols = cols;
+	slot.type = type;
+	slot.buffer = cv::Mat(rows, cols, type);
+	m_pooledBytes += slot.buffer.total() * slot.buffer.elemSize();
+	m_slots.push_back(slot);
+
+	cv::Mat buffer = m_slots.back().buffer;
+	_updateHighWaterMark();
+	return buffer;
+}
+
+cv::Mat FramePool::clone(const cv::Mat& src)
+{
+	if (src.empty())
+		return cv::Mat();
+
+	cv::Mat dst = acquire(src.rows, src.cols, src.type());
+	src.copyTo(dst);
+	return dst;
+}
+
+int FramePool::getNumHits() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_numHits;
+}
+
+int FramePool::getNumMisses() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_numMisses;
+}
+
+int FramePool::getNumBuffers() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_slots.size();
+}
+
+int FramePool::getNumInUse() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	int numInUse = 0;
+	for (int i = 0; i < m_slots.size(); i++)
+	{
+		if (!_isFree(m_slots[i].buffer))
+			numInUse++;
+	}
+	return numInUse;
+}
+
+int FramePool::getHighWaterMark() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_highWaterMark;
+}
+
+size_t FramePool::getPooledBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pooledBytes;
+}
+
+// The pool holds one reference, any other one is a user of the buffer.
+// Users drop their references on other threads, hence the atomic read.
+bool FramePool::_isFree(const cv::Mat& buffer)
+{
+	return buffer.u != nullptr && CV_XADD(&buffer.u->refcount, 0) == 1;
+}
+
+// Called with the lock held
+void FramePool::_updateHighWaterMark()
+{
+	int numInUse = 0;
+	for (int i = 0; i < m_slots.size(); i++)
+	{
+		if (!_isFree(m_slots[i].buffer))
+			numInUse++;
+	}
+
+	if (numInUse > m_highWaterMark)
+		m_highWaterMark = numInUse;
+}
@@ -0,0 +1,84 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __FRAME_POOL__
+#define __FRAME_POOL__
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Buffers kept per size and type, acquire() allocates outside the pool beyond
+#define FRAME_POOL_DEFAULT_SIZE 8
+
+// Preallocated cv::Mat buffers keyed by rows, cols and type.
+//
+// acquire() hands out a buffer nobody else references. There is no release:
+// the pool keeps one reference to each buffer, and a buffer is free again as
+// soon as every Mat header the pipeline made of it (copies, ROI views,
+// snapshots on other threads) is gone. So frames can be shared and passed
+// between threads like any other cv::Mat.
+//
+// When every buffer of the key is in use, up to maxBuffersPerKey buffers are
+// added to the pool; beyond that acquire() returns a plain Mat (a miss that
+// is not kept).
+//
+// Thread safe.
+class FramePool
+{
+public:
+	explicit FramePool(int maxBuffersPerKey = FRAME_POOL_DEFAULT_SIZE);
+
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	// Allocate numBuffers of the key up front, e.g. the input sizes at init
+	void reserve(int rows, int cols, int type, int numBuffers);
+
+	// Unshared buffer of the key, contents undefined
+	cv::Mat acquire(int rows, int cols, int type);
+
+	// Copy of src in a pooled buffer
+	cv::Mat clone(const cv::Mat& src);
+
+	int getNumHits() const;
+	int getNumMisses() const;
+	int getNumBuffers() const;         // Pooled buffers, all keys
+	int getNumInUse() const;           // Pooled buffers referenced outside the pool
+	int getHighWaterMark() const;      // Most pooled buffers in use at once
+	size_t getPooledBytes() const;
+
+private:
+	struct Slot
+	{
+		int rows;
+		int cols;
+		int type;
+		cv::Mat buffer;
+	};
+
+	static bool _isFree(const cv::Mat& buffer);
+	void _updateHighWaterMark();
+
+	mutable std::mutex m_mutex;
+	std::vector<Slot> m_slots;
+	int m_maxBuffersPerKey;
+
+	int m_numHits = 0;
+	int m_numMisses = 0;
+	int m_highWaterMark = 0;
+	size_t m_pooledBytes = 0;
+};
+
+#endif
@@ -13,6 +13,9 @@
 
 #include "json_log.hpp"
 #include "dms.hpp"
+#include <unistd.h>  // fsync, pread
+#include <fcntl.h>   // open
+#include <cstring>
 using json = nlohmann::json;
 
 JSON_LOG::JSON_LOG(std::string file)
@@ -20,649 +23,1440 @@ JSON_LOG::JSON_LOG(std::string file)
 	jsonFile = file;
 }
 
+JSON_LOG::JSON_LOG(std::string file, const JSON_LOG_Config_S& logConfig)
+{
+	jsonFile = file;
+	config = logConfig;
+	logLevel = config.logLevel;
+	SaveToJSONFile = config.saveToFile;
+	Open();
+
+	if (config.blackBoxMode && SaveToJSONFile)
+		StartBlackBox();
+	else if (config.asyncWrite)
+		StartWriterThread();
+}
+
 JSON_LOG::~JSON_LOG()
 {
+	StopBlackBox();
+	StopWriterThread();
+	Close();
+}
+
+bool JSON_LOG::Open()
+{
+	if (!SaveToJSONFile || !config.streamMode)
+		return true;
+
+	return EnableStreamMode(config.flushPolicy, config.flushInterval, config.format);
+}
+
+void JSON_LOG::Flush()
+{
+	FlushStreamFile(flushPolicy == JSON_LOG_FLUSH_FSYNC);
 }
 
-std::string JSON_LOG::JsonLogString(ADAS_Results adasResult,
+void JSON_LOG::Close()
+{
+	CloseStreamFile();
+}
+
+std::string JSON_LOG::JsonLogString(const ADAS_Results& adasResult,
                                     ADAS_Config_S *m_config,
-                                    std::vector<BoundingBox> boundingBoxLists[],
-                                    std::vector<Object> m_trackedObjList,
+                                    const std::vector<BoundingBox>* const (&boundingBoxLists)[JSON_LOG_DETECT_NUM_CLASSES],
+                                    const std::vector<Object>& m_trackedObjList,
                                     int m_frameIdx)
 {
-	// Create a JSON object
-	json jsonData;
-	json jsonDataCurrentFrame;
-	if(SaveToJSONFile){
-		// Read existing JSON file
-		std::ifstream inFile(jsonFile);
-		// json jsonData;
+	frameKey = std::to_string(m_frameIdx);
+
+	// Lists are in JSON_LOG_DETECT_CLASS order, the table only points at them
+	detectTable.build(boundingBoxLists);
+
+	bboxUtil::RescaleRatio ratio = bboxUtil::getRescaleRatio(
+		m_config->modelWidth, m_config->modelHeight,
+		m_config->frameWidth, m_config->frameHeight);
+
+	BuildFrameRecord(adasResult, &ratio, detectTable, nullptr, m_trackedObjList, m_frameIdx, pendingRecord);
+
+	// Compact line without a DOM, the writer does its own serialization
+	std::string jsonCurrentFrameString;
+	SerializeFrameRecord(pendingRecord, jsonCurrentFrameString);
+	SubmitFrameRecord();
+
+	return jsonCurrentFrameString;
+}
+
+
+std::string JSON_LOG::JsonLogString_2(const ADAS_Results& adasResult,
+									ADAS_Config_S* m_config,
+									const std::vector<BoundingBox>& m_humanBBoxList,
+									const std::vector<BoundingBox>& m_riderBBoxList,
+									const std::vector<BoundingBox>& m_vehicleBBoxList,
+									const std::vector<BoundingBox>& m_roadSignBBoxList,
+									const std::vector<BoundingBox>& m_stopSignBBoxList,
+									const std::vector<Object>& m_trackedObjList,
+									int m_frameIdx)
+{
+	frameKey = std::to_string(m_frameIdx);
+
+	// Same order as JSON_LOG_DETECT_CLASS
+	const std::vector<BoundingBox>* detectLists[JSON_LOG_DETECT_NUM_CLASSES] =
+	{
+		&m_humanBBoxList,
+		&m_riderBBoxList,
+		&m_vehicleBBoxList,
+		&m_roadSignBBoxList,
+		&m_stopSignBBoxList
+	};
+
+	detectTable.build(detectLists);
+
+	bboxUtil::RescaleRatio ratio = bboxUtil::getRescaleRatio(
+		m_config->modelWidth, m_config->modelHeight,
+		m_config->frameWidth, m_config->frameHeight);
+
+	BuildFrameRecord(adasResult, &ratio, detectTable, nullptr, m_trackedObjList, m_frameIdx, pendingRecord);
+
+	// Compact line without a DOM, the writer does its own serialization
+	std::string jsonCurrentFrameString;
+	SerializeFrameRecord(pendingRecord, jsonCurrentFrameString);
+	SubmitFrameRecord();
+
+	return jsonCurrentFrameString;
+}
+
+void JSON_LOG::SaveJsonLogFile(std::string jsonString)
+{
+	// Write the updated JSON to the file
+    std::ofstream outFile(jsonFile);
+    if (outFile.is_open()) {
+        outFile << jsonString;  // Adjust the indentation as needed
+        outFile.close();
+        JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, "Additional frame IDs appended to the JSON file.");
+    } else {
+        std::cerr << "Unable to open the file for writing.\n";
+        //return 1;
+    }
+
+}
+std::string JSON_LOG::GetJsonValueByKey(int targetFrameID)
+{
+    json jsonData;
+	std::string frameIDJsonString = "";
+	JSON_LOG_IndexEntry entry;
 
+	if (FindFrameRecord(targetFrameID, entry))
+	{
+		// Indexed stream log: read and parse only the record of this frame
+		std::string record;
+		int format = JSON_LOG_FORMAT_JSON;
+		if (!ReadFrameRecord(entry, record, format))
+		{
+			std::cerr << "Unable to read frame " << targetFrameID << " from " << jsonFile << "\n";
+			return "FILE_OPEN_FAILED";
+		}
+
+		// A torn record (e.g. the last one after a crash) is reported, not thrown
+		if (format == JSON_LOG_FORMAT_CBOR)
+			jsonData = json::from_cbor(record, true, false);
+		else if (format == JSON_LOG_FORMAT_MSGPACK)
+			jsonData = json::from_msgpack(record, true, false);
+		else
+			jsonData = json::parse(record, nullptr, false);
+
+		if (jsonData.is_discarded())
+		{
+			std::cerr << "Frame ID " << targetFrameID << " is corrupt in " << jsonFile << "\n";
+			return "FRAME_ID_NOT_FOUND_ERROR";
+		}
+	}
+	else if (isIndexed)
+	{
+		std::cerr << "Frame ID " << targetFrameID << " not found in the JSON.\n";
+		return "FRAME_ID_NOT_FOUND_ERROR";
+	}
+	else
+	{
+		// Legacy single document: read existing JSON file
+		std::ifstream inFile(jsonFile);
 		if (inFile.is_open()) {
-			inFile >> jsonData;
+			jsonData = json::parse(inFile, nullptr, false);
 			inFile.close();
 		} else {
 			std::cerr << "Unable to open the file.\n";
-			//return 1;
+			return "FILE_OPEN_FAILED";
 		}
 	}
-	// Create an "Vanisjline" array for each frame
-	if(SaveVanishLineLog)
+
+    // Check if the frame ID exists in the JSON
+    if (jsonData.contains("frame_ID") && jsonData["frame_ID"].contains(std::to_string(targetFrameID))) {
+        // Retrieve the "Obj" array for the specified frame ID
+        json objArray = jsonData["frame_ID"][std::to_string(targetFrameID)];
+
+		frameIDJsonString = objArray.dump(4);
+		JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, "================ targetFrameID = " << targetFrameID << "=======================");
+		JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, frameIDJsonString);
+		JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, "=========================================================");
+    } else {
+        std::cerr << "Frame ID " << targetFrameID << " not found in the JSON.\n";
+        return "FRAME_ID_NOT_FOUND_ERROR";
+    }
+    return frameIDJsonString;
+}
+std::string JSON_LOG::GetJSONFile()
+{
+    return jsonFile;
+};
+
+// Whether the existing log at path can be continued in format: a binary
+// log must carry the header of this version and format, a JSON Lines log
+// must not be a binary one. A missing or empty file always matches.
+static bool isStreamFileFormat(const std::string& path, int format)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return true;
+
+	unsigned char header[JSON_LOG_BINARY_HEADER_SIZE] = {0};
+	size_t numRead = fread(header, 1, sizeof(header), file);
+	fclose(file);
+
+	if (numRead == 0)
+		return true;
+
+	bool isBinary = (numRead >= 4 && memcmp(header, JSON_LOG_BINARY_MAGIC, 4) == 0);
+	if (format == JSON_LOG_FORMAT_JSON)
+		return !isBinary;
+
+	return isBinary
+		&& numRead == JSON_LOG_BINARY_HEADER_SIZE
+		&& header[4] == JSON_LOG_BINARY_VERSION
+		&& header[5] == (unsigned char)format;
+}
+
+// Move the log and its sidecars to <path>.<n>, the first n not taken
+static bool rotateStreamFile(const std::string& path)
+{
+	for (int n = 1; n < 1000; n++)
 	{
-		json vanishlineArray;
-		json vanishline;
-		vanishline["vanishlineY"] = adasResult.yVanish;
-		// Add the object to the "Obj" array
-		vanishlineArray.push_back(vanishline);
-		jsonData["frame_ID"][std::to_string(m_frameIdx)]["vanishLineY"] = vanishlineArray;
-		jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["vanishLineY"] = vanishlineArray;
+		std::string rotatedPath = path + "." + std::to_string(n);
+		if (access(rotatedPath.c_str(), F_OK) == 0)
+			continue;
+
+		if (rename(path.c_str(), rotatedPath.c_str()) != 0)
+			return false;
+
+		// The index and the track stream belong to the rotated log
+		rename((path + JSON_LOG_INDEX_SUFFIX).c_str(), (rotatedPath + JSON_LOG_INDEX_SUFFIX).c_str());
+		rename((path + JSON_LOG_TRACK_SUFFIX).c_str(), (rotatedPath + JSON_LOG_TRACK_SUFFIX).c_str());
+
+		std::cerr << "[JSON_LOG] " << path << " has another format, moved to " << rotatedPath << "\n";
+		return true;
 	}
+	return false;
+}
 
-	if(SaveLaneInfoLog)
-	{	
-		json laneArray;
-		// Add lane info
-		json obj;
-		obj["pLeftFar.x"] = 		adasResult.pLeftFar.x;
-		obj["pLeftFar.y"] = 		adasResult.pLeftFar.y;
-		obj["pLeftCarhood.x"] = 	adasResult.pLeftCarhood.x;
-		obj["pLeftCarhood.y"] = 	adasResult.pLeftCarhood.y;
-		obj["pRightFar.x"] = 		adasResult.pRightFar.x;
-		obj["pRightFar.y"] = 		adasResult.pRightFar.y;
-		obj["pRightCarhood.x"] = 	adasResult.pRightCarhood.x;
-		obj["pRightCarhood.y"] = 	adasResult.pRightCarhood.y;
-		obj["isDetectLine"] = 		adasResult.isDetectLine;
-		// Add the object to the "Obj" array
-		laneArray.push_back(obj);
-	
-		// Add the "Obj" array to the frame
-		jsonData["frame_ID"][std::to_string(m_frameIdx)]["LaneInfo"] = laneArray;
-		jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["LaneInfo"] = laneArray;
-	}
-	 cout<<"==========================================================="<<endl;
-	 cout<<"sizeof(boundingBoxLists)="<<sizeof(boundingBoxLists)<<endl;
-	 cout<<"sizeof(boundingBoxLists[0])="<<sizeof(boundingBoxLists[0])<<endl;
-    if(SaveDetObjLog)
-	{
-		//for (int j = 0; j < sizeof(boundingBoxLists) / sizeof(boundingBoxLists[0]); j++)
-		for (int j = 0; j < boundingBoxLists->size(); j++)
-		//for (int j = 0; j < sizeof(boundingBoxLists); j++)
+bool JSON_LOG::EnableStreamMode(int policy, int interval, int format)
+{
+	// Records already handed to the writer thread or the black box go to
+	// the current file, in its format
+	bool restartWriter = (writerQueue != nullptr);
+	if (restartWriter)
+		StopWriterThread();
+
+	if (isBlackBox)
+	{
+		std::unique_lock<std::mutex> lock(blackBoxMutex);
+		blackBoxCondition.wait(lock, [this] { return blackBoxDumpSize == 0; });
+	}
+
+	bool isOpened = false;
+	{
+		std::lock_guard<std::mutex> lock(fileMutex);
+		ReleaseStreamFile();
+
+		// Never append records of one format to a log of another
+		if (!isStreamFileFormat(jsonFile, format) && !rotateStreamFile(jsonFile))
+			std::cerr << "Unable to continue the stream file in this format: " << jsonFile << "\n";
+		else
+			isOpened = OpenStreamFile(policy, interval, format);
+	}
+
+	if (restartWriter)
+		StartWriterThread();
+
+	return isOpened;
+}
+
+// Called with fileMutex held
+bool JSON_LOG::OpenStreamFile(int policy, int interval, int format)
+{
+	streamFile = fopen(jsonFile.c_str(), "ab");
+	if (streamFile == nullptr)
+	{
+		std::cerr << "Unable to open the stream file: " << jsonFile << "\n";
+		return false;
+	}
+
+	config.format = format;
+	flushPolicy = policy;
+	flushInterval = interval > 0 ? interval : 1;
+	unflushedRecords = 0;
+
+	// New binary log starts with the header, an existing one is continued
+	fseek(streamFile, 0, SEEK_END);
+	if (format != JSON_LOG_FORMAT_JSON && ftell(streamFile) == 0)
+	{
+		unsigned char header[JSON_LOG_BINARY_HEADER_SIZE] = {0};
+		memcpy(header, JSON_LOG_BINARY_MAGIC, 4);
+		header[4] = JSON_LOG_BINARY_VERSION;
+		header[5] = (unsigned char)format;
+		fwrite(header, 1, sizeof(header), streamFile);
+		fflush(streamFile);
+	}
+	streamOffset = (uint64_t)ftell(streamFile);
+	flushedOffset = streamOffset;
+
+	// Keep the entries of earlier sessions, then continue the sidecar index
+	frameIndex.clear();
+	isIndexLoaded = false;
+	LoadFrameIndex();
+	indexFile = fopen((jsonFile + JSON_LOG_INDEX_SUFFIX).c_str(), "ab");
+	if (indexFile == nullptr)
+		std::cerr << "Unable to open the index file: " << jsonFile << JSON_LOG_INDEX_SUFFIX << "\n";
+	isIndexed = (indexFile != nullptr);
+
+	if (config.saveTrackStream)
+		OpenTrackStream();
+
+	SaveToStreamFile = true;
+	return true;
+}
+
+static void writeLE(unsigned char* buf, uint64_t value, int numBytes)
+{
+	for (int i = 0; i < numBytes; i++)
+		buf[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+}
+
+static uint64_t readLE(const unsigned char* buf, int numBytes)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < numBytes; i++)
+		value |= (uint64_t)buf[i] << (8 * i);
+	return value;
+}
+
+void JSON_LOG::AppendStreamRecord(const char* data, size_t size, int frameIdx)
+{
+	std::lock_guard<std::mutex> lock(fileMutex);
+
+	if (streamFile == nullptr)
+		return;
+
+	JSON_LOG_IndexEntry entry;
+	entry.frameIdx = frameIdx;
+	entry.length = (uint32_t)size;
+
+	if (config.format == JSON_LOG_FORMAT_JSON)
+	{
+		entry.offset = streamOffset;
+		fwrite(data, 1, size, streamFile);
+		fputc('\n', streamFile);
+		streamOffset += size + 1;
+	}
+	else
+	{
+		unsigned char prefix[4];
+		writeLE(prefix, size, 4);
+		fwrite(prefix, 1, sizeof(prefix), streamFile);
+		fwrite(data, 1, size, streamFile);
+		entry.offset = streamOffset + sizeof(prefix);
+		streamOffset += sizeof(prefix) + size;
+	}
+
+	if (indexFile != nullptr)
+	{
+		unsigned char buf[JSON_LOG_INDEX_ENTRY_SIZE];
+		writeLE(buf, (uint32_t)entry.frameIdx, 4);
+		writeLE(buf + 4, entry.length, 4);
+		writeLE(buf + 8, entry.offset, 8);
+		fwrite(buf, 1, sizeof(buf), indexFile);
+	}
+	frameIndex[frameIdx] = entry;  // Frame IDs wrap around, latest wins
+
+	if (flushPolicy == JSON_LOG_FLUSH_NONE)
+		return;
+
+	if (++unflushedRecords >= flushInterval)
+	{
+		fflush(streamFile);
+		if (indexFile != nullptr)
+			fflush(indexFile);
+		if (trackFile != nullptr)
+			fflush(trackFile);
+		if (flushPolicy == JSON_LOG_FLUSH_FSYNC)
+			fsync(fileno(streamFile));
+		flushedOffset = streamOffset;
+		unflushedRecords = 0;
+	}
+}
+
+void JSON_LOG::FlushStreamFile(bool sync)
+{
+	std::lock_guard<std::mutex> lock(fileMutex);
+
+	if (streamFile == nullptr)
+		return;
+
+	fflush(streamFile);
+	if (indexFile != nullptr)
+		fflush(indexFile);
+	if (trackFile != nullptr)
+		fflush(trackFile);
+	if (sync)
+	{
+		fsync(fileno(streamFile));
+		if (indexFile != nullptr)
+			fsync(fileno(indexFile));
+		if (trackFile != nullptr)
+			fsync(fileno(trackFile));
+	}
+	flushedOffset = streamOffset;
+	unflushedRecords = 0;
+}
+
+void JSON_LOG::CloseStreamFile()
+{
+	std::lock_guard<std::mutex> lock(fileMutex);
+	ReleaseStreamFile();
+}
+
+// Called with fileMutex held
+void JSON_LOG::ReleaseStreamFile()
+{
+	SaveToStreamFile = false;
+	SaveToTrackStream = false;
+
+	// The next lookup may read another (or a rotated) file
+	if (readFd >= 0)
+	{
+		close(readFd);
+		readFd = -1;
+	}
+
+	if (streamFile == nullptr)
+		return;
+
+	fflush(streamFile);
+	if (flushPolicy == JSON_LOG_FLUSH_FSYNC)
+		fsync(fileno(streamFile));
+	fclose(streamFile);
+	streamFile = nullptr;
+
+	if (indexFile != nullptr)
+	{
+		fclose(indexFile);
+		indexFile = nullptr;
+	}
+
+	if (trackFile != nullptr)
+	{
+		fclose(trackFile);
+		trackFile = nullptr;
+	}
+	delete trackEncoder;
+	trackEncoder = nullptr;
+}
+
+// ============================================
+//             Tracked Object Stream
+// ============================================
+// Called with fileMutex held
+bool JSON_LOG::OpenTrackStream()
+{
+	std::string trackPath = jsonFile + JSON_LOG_TRACK_SUFFIX;
+	int quantStep = config.trackQuantStep;
+
+	// An earlier session is continued with its quantization step. The first
+	// record of this session is a keyframe, so no state carries over.
+	FILE* prevFile = fopen(trackPath.c_str(), "rb");
+	if (prevFile != nullptr)
+	{
+		uint8_t header[TRACK_DELTA_HEADER_SIZE];
+		TrackDeltaDecoder decoder;
+		if (fread(header, 1, sizeof(header), prevFile) == sizeof(header)
+			&& decoder.readHeader(header, sizeof(header)))
+			quantStep = decoder.getQuantStep();
+		fclose(prevFile);
+	}
+
+	trackFile = fopen(trackPath.c_str(), "ab");
+	if (trackFile == nullptr)
+	{
+		std::cerr << "Unable to open the track stream file: " << trackPath << "\n";
+		return false;
+	}
+
+	trackEncoder = new TrackDeltaEncoder(config.trackKeyframeInterval, quantStep);
+
+	fseek(trackFile, 0, SEEK_END);
+	if (ftell(trackFile) == 0)
+	{
+		trackBuffer.clear();
+		trackEncoder->writeHeader(trackBuffer);
+		fwrite(trackBuffer.data(), 1, trackBuffer.size(), trackFile);
+		fflush(trackFile);
+	}
+
+	SaveToTrackStream = true;
+	return true;
+}
+
+void JSON_LOG::WriteTrackRecord(const JSON_LOG_FrameRecord& record)
+{
+	if (trackEncoder == nullptr)
+		return;
+
+	trackFrame.frameIdx = record.frameIdx;
+	trackFrame.objects.resize(record.trackObjList.size());
+	for (int i = 0; i < record.trackObjList.size(); i++)
+	{
+		const JSON_LOG_TrackRecord& track = record.trackObjList[i];
+		TrackDeltaObject& obj = trackFrame.objects[i];
+		obj.label = track.label;
+		obj.id = (int)track.id;
+		obj.x1 = (int)track.bbox.x1;
+		obj.y1 = (int)track.bbox.y1;
+		obj.x2 = (int)track.bbox.x2;
+		obj.y2 = (int)track.bbox.y2;
+		obj.distance = (int)track.distanceToCamera;
+	}
+
+	trackBuffer.clear();
+	trackEncoder->encodeFrame(trackFrame, trackBuffer);
+
+	std::lock_guard<std::mutex> lock(fileMutex);
+	if (trackFile != nullptr)
+		fwrite(trackBuffer.data(), 1, trackBuffer.size(), trackFile);
+}
+
+// ============================================
+//                 Frame Index
+// ============================================
+bool JSON_LOG::LoadFrameIndex()
+{
+	// Caller holds fileMutex
+	isIndexLoaded = true;
+
+	// Record format of the file the index points into, from its header. Only
+	// lookups use it, the format this logger writes stays config.format.
+	readFormat = JSON_LOG_FORMAT_JSON;
+
+	FILE* logFile = fopen(jsonFile.c_str(), "rb");
+	unsigned char header[JSON_LOG_BINARY_HEADER_SIZE];
+	if (logFile != nullptr)
+	{
+		if (fread(header, 1, sizeof(header), logFile) == sizeof(header)
+			&& memcmp(header, JSON_LOG_BINARY_MAGIC, 4) == 0)
+			readFormat = header[5];
+		fclose(logFile);
+	}
+
+	FILE* file = fopen((jsonFile + JSON_LOG_INDEX_SUFFIX).c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	unsigned char buf[JSON_LOG_INDEX_ENTRY_SIZE];
+	while (fread(buf, 1, sizeof(buf), file) == sizeof(buf))  // Ignore a torn last entry
+	{
+		JSON_LOG_IndexEntry entry;
+		entry.frameIdx = (int32_t)readLE(buf, 4);
+		entry.length = (uint32_t)readLE(buf + 4, 4);
+		entry.offset = readLE(buf + 8, 8);
+		frameIndex[entry.frameIdx] = entry;
+	}
+	fclose(file);
+
+	isIndexed = true;
+	return true;
+}
+
+bool JSON_LOG::FindFrameRecord(int targetFrameID, JSON_LOG_IndexEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(fileMutex);
+
+	if (!isIndexLoaded)
+		LoadFrameIndex();
+
+	auto it = frameIndex.find(targetFrameID);
+	if (it == frameIndex.end())
+		return false;
+
+	entry = it->second;
+	return true;
+}
+
+bool JSON_LOG::ReadFrameRecord(const JSON_LOG_IndexEntry& entry, std::string& record, int& format)
+{
+	// Held through the read, a stream switch closes readFd (ReleaseStreamFile)
+	std::lock_guard<std::mutex> lock(fileMutex);
+
+	// Record may still sit in the stdio buffer of the writer
+	if (streamFile != nullptr && entry.offset + entry.length > flushedOffset)
+	{
+		fflush(streamFile);
+		flushedOffset = streamOffset;
+	}
+
+	if (readFd < 0)
+		readFd = open(jsonFile.c_str(), O_RDONLY);
+	if (readFd < 0)
+		return false;
+
+	format = readFormat;
+
+	record.resize(entry.length);
+	size_t done = 0;
+	while (done < entry.length)
+	{
+		ssize_t ret = pread(readFd, &record[done], entry.length - done, (off_t)(entry.offset + done));
+		if (ret <= 0)
+			return false;
+		done += ret;
+	}
+	return true;
+}
+
+// ============================================
+//                Frame Record
+// ============================================
+// Detected object classes, indexed by JSON_LOG_DETECT_CLASS
+static constexpr const char* detectLabels[JSON_LOG_DETECT_NUM_CLASSES] =
+{
+	"HUMAN",
+	"SMALL_VEHICLE",
+	"VEHICLE",
+	"ROAD_SIGN",
+	"STOP_SIGN"
+};
+
+static constexpr int compareLabels(const char* a, const char* b)
+{
+	while (*a != '\0' && *a == *b)
+	{
+		a++;
+		b++;
+	}
+	return (unsigned char)*a - (unsigned char)*b;
+}
+
+// Class indices ordered by label, matching the key order of the std::map
+// backed nlohmann::json object
+struct DetectLabelOrder
+{
+	int classIdx[JSON_LOG_DETECT_NUM_CLASSES];
+};
+
+static constexpr DetectLabelOrder sortDetectLabels()
+{
+	DetectLabelOrder order = {};
+	for (int i = 0; i < JSON_LOG_DETECT_NUM_CLASSES; i++)
+	{
+		int j = i;
+		for (; j > 0 && compareLabels(detectLabels[i], detectLabels[order.classIdx[j - 1]]) < 0; j--)
+			order.classIdx[j] = order.classIdx[j - 1];
+		order.classIdx[j] = i;
+	}
+	return order;
+}
+
+static constexpr DetectLabelOrder detectLabelOrder = sortDetectLabels();
+
+static const char* trackLabel(int label)
+{
+	if (label == 0)
+		return "HUMAN";
+	else if (label == 1)
+		return "RIDER";
+	else if (label == 2)
+		return "VEHICLE";
+	return "";
+}
+
+void JSON_LOG::LogFrame(const ADAS_Results& adasResult,
+						ADAS_Config_S* m_config,
+						const std::vector<BoundingBox>& m_humanBBoxList,
+						const std::vector<BoundingBox>& m_riderBBoxList,
+						const std::vector<BoundingBox>& m_vehicleBBoxList,
+						const std::vector<BoundingBox>& m_roadSignBBoxList,
+						const std::vector<BoundingBox>& m_stopSignBBoxList,
+						const std::vector<Object>& m_trackedObjList,
+						int m_frameIdx)
+{
+	// Same order as JSON_LOG_DETECT_CLASS
+	const std::vector<BoundingBox>* detectLists[JSON_LOG_DETECT_NUM_CLASSES] =
+	{
+		&m_humanBBoxList,
+		&m_riderBBoxList,
+		&m_vehicleBBoxList,
+		&m_roadSignBBoxList,
+		&m_stopSignBBoxList
+	};
+
+	detectTable.build(detectLists);
+
+	bboxUtil::RescaleRatio ratio = bboxUtil::getRescaleRatio(
+		m_config->modelWidth, m_config->modelHeight,
+		m_config->frameWidth, m_config->frameHeight);
+
+	BuildFrameRecord(adasResult, &ratio, detectTable, nullptr, m_trackedObjList, m_frameIdx, pendingRecord);
+	SubmitFrameRecord();
+}
+
+void JSON_LOG::LogFrame(const ADAS_Results& adasResult,
+						const DetectionTable& detections,
+						const std::vector<BoundingBox>& trackBoxes,
+						const std::vector<Object>& m_trackedObjList,
+						int m_frameIdx)
+{
+	BuildFrameRecord(adasResult, nullptr, detections, &trackBoxes, m_trackedObjList, m_frameIdx, pendingRecord);
+	SubmitFrameRecord();
+}
+
+void JSON_LOG::SubmitFrameRecord()
+{
+	if (isBlackBox)
+		PushBlackBoxRecord(pendingRecord);
+	else if (writerQueue != nullptr)
+		PushFrameRecord(pendingRecord);
+	else
+		WriteFrameRecord(pendingRecord);
+}
+
+void JSON_LOG::BuildFrameRecord(const ADAS_Results& adasResult,
+								const bboxUtil::RescaleRatio* ratio,
+								const DetectionTable& detections,
+								const std::vector<BoundingBox>* trackBoxes,
+								const std::vector<Object>& m_trackedObjList,
+								int m_frameIdx,
+								JSON_LOG_FrameRecord& record)
+{
+	record.frameIdx = m_frameIdx;
+	record.eventType = adasResult.eventType;
+	record.yVanish = adasResult.yVanish;
+	record.isDetectLine = adasResult.isDetectLine;
+	record.pLeftFar = adasResult.pLeftFar;
+	record.pLeftCarhood = adasResult.pLeftCarhood;
+	record.pRightFar = adasResult.pRightFar;
+	record.pRightCarhood = adasResult.pRightCarhood;
+
+	// clear() keeps the capacity, so steady state needs no allocation
+	record.detectObjList.clear();
+	record.trackObjList.clear();
+
+	if (SaveDetObjLog)
+	{
+		const DetectionColumns columns = detections.columns(detections.all());
+
+		for (size_t i = 0; i < columns.size; i++)
 		{
-			std::vector<BoundingBox>& boundingBoxList = boundingBoxLists[j];
-
-			for (int i = 0; i < boundingBoxList.size(); i++)
-			{	
-				cout<<"boundingBoxList.size() = "<<boundingBoxList.size()<<endl;
-				json detectArray;
-				BoundingBox lastBox = boundingBoxList[i];
-				BoundingBox rescaleBox(-1, -1, -1, -1, -1);  
-
-				utils::rescaleBBox(
-				lastBox, rescaleBox,
-				m_config->modelWidth, m_config->modelHeight,
-				m_config->frameWidth, m_config->frameHeight);
-
-				string label = "";
-				if(rescaleBox.label==0)
-				{
-					label = "HUMAN";
-				}
-				else if(rescaleBox.label==1){
-					label = "RIDER";
-				}
-				else if(rescaleBox.label==2){
-					label = "VEHICLE";
-				}
-				else{
-					label = "UNKNOWN";
-				}
-				// Add track obj
-				json det;
-				det["detectObj.x1"] = 	 rescaleBox.x1;
-				det["detectObj.y1"] = 	 rescaleBox.y1;
-				det["detectObj.x2"] = 	 rescaleBox.x2;
-				det["detectObj.y2"] = 	 rescaleBox.y2;
-				det["detectObj.objID"] = rescaleBox.objID;
-				det["detectObj.label"] = rescaleBox.label;
-				det["detectObj.confidence"] = rescaleBox.confidence;
-				det["detectObj.boxID"] = rescaleBox.boxID;
-
-				// Add the track obj to the trackArray
-				detectArray.push_back(det);
-				// Add the "Track" array to the frame
-				jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"][label] = detectArray;
-				jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"][label] = detectArray;
-			}
+			record.detectObjList.emplace_back();
+			JSON_LOG_DetectRecord& det = record.detectObjList.back();
+			det.classIdx = columns.classIdx[i];
+			det.bbox = detections.getBox(i);  // Whole source box
+
+			if (ratio != nullptr)
+				bboxUtil::rescaleBBox(det.bbox, det.bbox, *ratio);
 		}
 	}
-	
-	if(SaveTrackObjLog)
+
+	if (SaveTrackObjLog)
+	{
+		for (int i = 0; i < m_trackedObjList.size(); i++)
+		{
+			const Object& trackedObj = m_trackedObjList[i];
+			if (trackedObj.bboxList.empty())
+				continue;
+
+			record.trackObjList.emplace_back();
+			JSON_LOG_TrackRecord& track = record.trackObjList.back();
+
+			const BoundingBox& lastBox = trackedObj.bboxList.back();
+			if (ratio != nullptr)
+				bboxUtil::rescaleBBox(lastBox, track.bbox, *ratio);
+			else
+				track.bbox = (*trackBoxes)[i];
+
+			track.label = lastBox.label;
+			track.distanceToCamera = round(trackedObj.distanceToCamera);
+			track.id = trackedObj.id;
+		}
+	}
+}
+
+json JSON_LOG::FrameRecordToJson(const JSON_LOG_FrameRecord& record)
+{
+	json jsonDataCurrentFrame;
+	json& frame = jsonDataCurrentFrame["frame_ID"][std::to_string(record.frameIdx)];
+
+	json ADAS;
+	if (SaveLDWLog)
+	{
+		bool isLDW = (record.eventType == ADAS_EVENT_LDW || record.eventType == ADAS_EVENT_LDW_FCW);
+		ADAS["LDW"] = isLDW ? 1 : 0;
+	}
+	if (SaveFCWLog)
 	{
-		for (int i = 0; i < m_trackedObjList.size(); i++)
-		{   // Create an "Track" array for each frame	
-			json trackArray;
-			const Object& trackedObj = m_trackedObjList[i];
-			if (trackedObj.bboxList.empty())
-				continue;
-			BoundingBox lastBox = trackedObj.bboxList.back();
-			BoundingBox rescaleBox(-1, -1, -1, -1, -1);
-
-			// Rescale BBoxes
-			//#ifdef SAV837
-			utils::rescaleBBox(
-			lastBox, rescaleBox,
-			m_config->modelWidth, m_config->modelHeight,
-			m_config->frameWidth, m_config->frameHeight);
-			//#endif
-			string label = "";
-			if(lastBox.label==0)
-			{
-				label = "HUMAN";
-			}
-			else if(lastBox.label==1)
-			{
-				label = "RIDER";
-			}
-			else if(lastBox.label==2)
-			{
-				label = "VEHICLE";
-			}
-			// Add track obj
-			json obj2;
-			obj2["trackObj.x1"] = 	 rescaleBox.x1;
-			obj2["trackObj.y1"] = 	 rescaleBox.y1;
-			obj2["trackObj.x2"] = 	 rescaleBox.x2;
-			obj2["trackObj.y2"] = 	 rescaleBox.y2;
-			obj2["trackObj.status"] = trackedObj.status;
-			obj2["trackObj.distanceToCamera"] = trackedObj.distanceToCamera;
-			obj2["trackObj.bbox.label"] = label;
-			obj2["trackedObj.id"] = trackedObj.id;
-
-			// Add the track obj to the trackArray
-			trackArray.push_back(obj2);
-			// Add the "Track" array to the frame
-			jsonData["frame_ID"][std::to_string(m_frameIdx)]["trackObj"][label] = trackArray;
-			jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["trackObj"][label] = trackArray;
+		bool isFCW = (record.eventType == ADAS_EVENT_FCW || record.eventType == ADAS_EVENT_LDW_FCW);
+		ADAS["FCW"] = isFCW ? 1 : 0;
+	}
+	frame["ADAS"].push_back(ADAS);
 
-		}
+	if (SaveVanishLineLog)
+	{
+		json vanishline;
+		vanishline["vanishlineY"] = record.yVanish;
+		frame["vanishLineY"].push_back(vanishline);
+	}
+
+	if (SaveLaneInfoLog)
+	{
+		json obj;
+		obj["pLeftFar.x"] = 		record.pLeftFar.x;
+		obj["pLeftFar.y"] = 		record.pLeftFar.y;
+		obj["pLeftCarhood.x"] = 	record.pLeftCarhood.x;
+		obj["pLeftCarhood.y"] = 	record.pLeftCarhood.y;
+		obj["pRightFar.x"] = 		record.pRightFar.x;
+		obj["pRightFar.y"] = 		record.pRightFar.y;
+		obj["pRightCarhood.x"] = 	record.pRightCarhood.x;
+		obj["pRightCarhood.y"] = 	record.pRightCarhood.y;
+		obj["isDetectLine"] = 		record.isDetectLine;
+		frame["LaneInfo"].push_back(obj);
 	}
 
-    // Convert the JSON object to a string with indentation
-	if(ShowJsonLog)
+	for (int i = 0; i < record.detectObjList.size(); i++)
 	{
-	std::string jsonString = jsonData.dump(4);
-	std::string jsonCurrentFrameString = jsonDataCurrentFrame.dump(4);
-	cout<<"===================================================================================="<<endl;
-	cout<<jsonCurrentFrameString<<endl;
-	cout<<"===================================================================================="<<endl;
+		const JSON_LOG_DetectRecord& detRecord = record.detectObjList[i];
+		const char* label = detectLabels[detRecord.classIdx];
+
+		json det;
+		det["detectObj.x1"] = 	 detRecord.bbox.x1;
+		det["detectObj.y1"] = 	 detRecord.bbox.y1;
+		det["detectObj.x2"] = 	 detRecord.bbox.x2;
+		det["detectObj.y2"] = 	 detRecord.bbox.y2;
+		det["detectObj.label"] = label;
+		det["detectObj.confidence"] = detRecord.bbox.confidence;
+		frame["detectObj"][label].push_back(det);
 	}
-    
-	std::string jsonString = jsonData.dump(4);
-	std::string jsonCurrentFrameString = jsonDataCurrentFrame.dump(4);
-	if(SaveToJSONFile)
+
+	// Tracked objects may go to the .trk stream only
+	bool isTrackObjLogged = !(SaveToTrackStream && config.trackStreamOnly);
+	for (int i = 0; isTrackObjLogged && i < record.trackObjList.size(); i++)
 	{
-		SaveJsonLogFile(jsonString);
+		const JSON_LOG_TrackRecord& trackRecord = record.trackObjList[i];
+		const char* label = trackLabel(trackRecord.label);
+
+		json track;
+		track["trackObj.x1"] = 	 trackRecord.bbox.x1;
+		track["trackObj.y1"] = 	 trackRecord.bbox.y1;
+		track["trackObj.x2"] = 	 trackRecord.bbox.x2;
+		track["trackObj.y2"] = 	 trackRecord.bbox.y2;
+		track["trackObj.distanceToCamera"] = trackRecord.distanceToCamera;
+		track["trackObj.bbox.label"] = label;
+		track["trackedObj.id"] = trackRecord.id;
+		frame["trackObj"][label].push_back(track);
 	}
-	return jsonCurrentFrameString;
-}
 
+	return jsonDataCurrentFrame;
+}
 
-std::string JSON_LOG::JsonLogString_2(ADAS_Results adasResult, 
-									ADAS_Config_S *m_config, 
-									std::vector<BoundingBox> m_humanBBoxList, 
-									std::vector<BoundingBox> m_riderBBoxList, 
-									std::vector<BoundingBox> m_vehicleBBoxList, 
-									std::vector<BoundingBox> m_roadSignBBoxList, 
-									std::vector<BoundingBox> m_stopSignBBoxList, 
-									std::vector<Object> m_trackedObjList, 
-									int m_frameIdx)
+void JSON_LOG::WriteFrameRecord(const JSON_LOG_FrameRecord& record)
 {
-    // Create a JSON object
-	json jsonData;
-	json jsonDataCurrentFrame;
-	if(SaveToJSONFile){
-		// Read existing JSON file
-		std::ifstream inFile(jsonFile);
-		// json jsonData;
+	JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, "====================================================================================");
+	JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, FrameRecordToJson(record).dump(4));
+	JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, "====================================================================================");
 
-		if (inFile.is_open()) {
+	if (SaveToTrackStream)
+		WriteTrackRecord(record);
+
+	if (SaveToStreamFile && config.format == JSON_LOG_FORMAT_JSON)
+	{
+		SerializeFrameRecord(record, recordBuffer);
+		AppendStreamRecord(recordBuffer.data(), recordBuffer.size(), record.frameIdx);
+	}
+	else if (SaveToStreamFile)
+	{
+		binaryBuffer.clear();
+		if (config.format == JSON_LOG_FORMAT_CBOR)
+			json::to_cbor(FrameRecordToJson(record), binaryBuffer);
+		else
+			json::to_msgpack(FrameRecordToJson(record), binaryBuffer);
+		AppendStreamRecord((const char*)binaryBuffer.data(), binaryBuffer.size(), record.frameIdx);
+	}
+	else if (SaveToJSONFile)
+	{
+		// Legacy single document: read, merge this frame, rewrite
+		json jsonDataCurrentFrame = FrameRecordToJson(record);
+		json jsonData;
+		std::ifstream inFile(jsonFile);
+		if (inFile.is_open())
+		{
 			inFile >> jsonData;
 			inFile.close();
-		} else {
-			std::cerr << "Unable to open the file.\n";
-			//return 1;
 		}
+
+		std::string key = std::to_string(record.frameIdx);
+		jsonData["frame_ID"][key] = jsonDataCurrentFrame["frame_ID"][key];
+		SaveJsonLogFile(jsonData.dump(4));
 	}
+}
 
-	json ADAS;
-	if(SaveLDWLog)
+void JSON_LOG::SerializeFrameRecord(const JSON_LOG_FrameRecord& record, std::string& out)
+{
+	// Byte-identical to FrameRecordToJson(record).dump(), without building
+	// the DOM. Object members are emitted in sorted key order.
+	out.clear();
+	JsonRecordWriter w(out);
+
+	w.raw("{\"frame_ID\":{\"");
+	w.number(record.frameIdx);
+	w.raw("\":{");
+
+	// ADAS
+	w.raw("\"ADAS\":[");
+	if (SaveLDWLog || SaveFCWLog)
 	{
-		
-		int LDW_value = 0;
-		if (adasResult.eventType == ADAS_EVENT_LDW)
+		w.raw('{');
+		if (SaveFCWLog)
 		{
-			LDW_value = 1;
+			bool isFCW = (record.eventType == ADAS_EVENT_FCW || record.eventType == ADAS_EVENT_LDW_FCW);
+			w.raw("\"FCW\":");
+			w.number(isFCW ? 1 : 0);
 		}
-		else if (adasResult.eventType == ADAS_EVENT_LDW_FCW)
+		if (SaveLDWLog)
 		{
-			LDW_value = 1;
+			bool isLDW = (record.eventType == ADAS_EVENT_LDW || record.eventType == ADAS_EVENT_LDW_FCW);
+			if (SaveFCWLog)
+				w.raw(',');
+			w.raw("\"LDW\":");
+			w.number(isLDW ? 1 : 0);
 		}
-		ADAS["LDW"] = LDW_value;
+		w.raw('}');
 	}
-
-	if(SaveFCWLog)
+	else
 	{
-		int FCW_value = 0;
-		if (adasResult.eventType == ADAS_EVENT_FCW)
-		{
-			FCW_value = 1;
-		}
-		else if (adasResult.eventType == ADAS_EVENT_LDW_FCW)
-		{
-			FCW_value = 1;
-		}
-		ADAS["FCW"] = FCW_value;
+		w.raw("null");
 	}
-	jsonData["frame_ID"][std::to_string(m_frameIdx)]["ADAS"].push_back(ADAS);
-	jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["ADAS"].push_back(ADAS);
+	w.raw(']');
 
-	// Create an "Vanisjline" array for each frame
-	if(SaveVanishLineLog)
+	// LaneInfo
+	if (SaveLaneInfoLog)
 	{
-		json vanishlineArray;
-		json vanishline;
-		vanishline["vanishlineY"] = adasResult.yVanish;
-		// Add the object to the "Obj" array
-		vanishlineArray.push_back(vanishline);
-		jsonData["frame_ID"][std::to_string(m_frameIdx)]["vanishLineY"] = vanishlineArray;
-		jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["vanishLineY"] = vanishlineArray;
+		w.raw(",\"LaneInfo\":[{\"isDetectLine\":");
+		w.number(record.isDetectLine);
+		w.raw(",\"pLeftCarhood.x\":");  w.number(record.pLeftCarhood.x);
+		w.raw(",\"pLeftCarhood.y\":");  w.number(record.pLeftCarhood.y);
+		w.raw(",\"pLeftFar.x\":");      w.number(record.pLeftFar.x);
+		w.raw(",\"pLeftFar.y\":");      w.number(record.pLeftFar.y);
+		w.raw(",\"pRightCarhood.x\":"); w.number(record.pRightCarhood.x);
+		w.raw(",\"pRightCarhood.y\":"); w.number(record.pRightCarhood.y);
+		w.raw(",\"pRightFar.x\":");     w.number(record.pRightFar.x);
+		w.raw(",\"pRightFar.y\":");     w.number(record.pRightFar.y);
+		w.raw("}]");
 	}
 
-	if(SaveLaneInfoLog)
-	{	
-		json laneArray;
-		// Add lane info
-		json obj;
-		obj["pLeftFar.x"] = 		adasResult.pLeftFar.x;
-		obj["pLeftFar.y"] = 		adasResult.pLeftFar.y;
-		obj["pLeftCarhood.x"] = 	adasResult.pLeftCarhood.x;
-		obj["pLeftCarhood.y"] = 	adasResult.pLeftCarhood.y;
-		obj["pRightFar.x"] = 		adasResult.pRightFar.x;
-		obj["pRightFar.y"] = 		adasResult.pRightFar.y;
-		obj["pRightCarhood.x"] = 	adasResult.pRightCarhood.x;
-		obj["pRightCarhood.y"] = 	adasResult.pRightCarhood.y;
-		obj["isDetectLine"] = 		adasResult.isDetectLine;
-		// Add the object to the "Obj" array
-		laneArray.push_back(obj);
-	
-		// Add the "Obj" array to the frame
-		jsonData["frame_ID"][std::to_string(m_frameIdx)]["LaneInfo"] = laneArray;
-		jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["LaneInfo"] = laneArray;
-	}
-	//  cout<<"==========================================================="<<endl;
-	//  cout<<"sizeof(boundingBoxLists)="<<sizeof(boundingBoxLists)<<endl;
-	//  cout<<"sizeof(boundingBoxLists[0])="<<sizeof(boundingBoxLists[0])<<endl;
-    if(SaveDetObjLog)
-	{
-		// //for (int j = 0; j < sizeof(boundingBoxLists) / sizeof(boundingBoxLists[0]); j++)
-		// for (int j = 0; j < boundingBoxLists->size(); j++)
-		// //for (int j = 0; j < sizeof(boundingBoxLists); j++)
-		// {
-		// 	std::vector<BoundingBox>& boundingBoxList = boundingBoxLists[j];
-			// VEHICLE
-			for (int i = 0; i < m_vehicleBBoxList.size(); i++)
-			{	
-				cout<<"m_vehicleBBoxList.size() = "<<m_vehicleBBoxList.size()<<endl;
-				json detectArray;
-				BoundingBox lastBox = m_vehicleBBoxList[i];
-				BoundingBox rescaleBox(-1, -1, -1, -1, -1);  
-
-				utils::rescaleBBox(
-				lastBox, rescaleBox,
-				m_config->modelWidth, m_config->modelHeight,
-				m_config->frameWidth, m_config->frameHeight);
-
-				string label = "";
-				if(rescaleBox.label==0)
+	// detectObj
+	if (!record.detectObjList.empty())
+	{
+		bool isFirstGroup = true;
+
+		w.raw(",\"detectObj\":{");
+		for (int k = 0; k < JSON_LOG_DETECT_NUM_CLASSES; k++)
+		{
+			const int classIdx = detectLabelOrder.classIdx[k];
+			const char* label = detectLabels[classIdx];
+			bool isFirstObj = true;
+
+			for (int i = 0; i < record.detectObjList.size(); i++)
+			{
+				const JSON_LOG_DetectRecord& det = record.detectObjList[i];
+				if (det.classIdx != classIdx)
+					continue;
+
+				if (isFirstObj)
 				{
-					label = "HUMAN";
-				}
-				else if(rescaleBox.label==1){
-					label = "RIDER";
+					if (!isFirstGroup)
+						w.raw(',');
+					w.string(label);
+					w.raw(":[");
+					isFirstGroup = false;
 				}
-				else if(rescaleBox.label==2){
-					label = "VEHICLE";
-				}
-				else{
-					label = "UNKNOWN";
-				}
-				// Add track obj
-				json det;
-				det["detectObj.x1"] = 	 rescaleBox.x1;
-				det["detectObj.y1"] = 	 rescaleBox.y1;
-				det["detectObj.x2"] = 	 rescaleBox.x2;
-				det["detectObj.y2"] = 	 rescaleBox.y2;
-				//det["detectObj.objID"] = rescaleBox.objID;
-				det["detectObj.label"] = "VEHICLE";
-				det["detectObj.confidence"] = rescaleBox.confidence;
-				//det["detectObj.boxID"] = rescaleBox.boxID;
-
-				// Add the track obj to the trackArray
-				// detectArray.push_back(det);
-				// Add the "Track" array to the frame	
-				jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["VEHICLE"].push_back(det);
-				jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["VEHICLE"].push_back(det);	
-			}
-			
-			// HUMAN
-			for (int i = 0; i < m_humanBBoxList.size(); i++)
-			{	
-				cout<<"m_humanBBoxList.size() = "<<m_humanBBoxList.size()<<endl;
-				json detectArray;
-				BoundingBox lastBox = m_humanBBoxList[i];
-				BoundingBox rescaleBox(-1, -1, -1, -1, -1);  
-
-				utils::rescaleBBox(
-				lastBox, rescaleBox,
-				m_config->modelWidth, m_config->modelHeight,
-				m_config->frameWidth, m_config->frameHeight);
-
-				string label = "";
-				if(rescaleBox.label==0)
+				else
 				{
-					label = "HUMAN";
-				}
-				else if(rescaleBox.label==1){
-					label = "RIDER";
+					w.raw(',');
 				}
-				else if(rescaleBox.label==2){
-					label = "VEHICLE";
-				}
-				else{
-					label = "UNKNOWN";
-				}
-				// Add track obj
-				json det;
-				det["detectObj.x1"] = 	 rescaleBox.x1;
-				det["detectObj.y1"] = 	 rescaleBox.y1;
-				det["detectObj.x2"] = 	 rescaleBox.x2;
-				det["detectObj.y2"] = 	 rescaleBox.y2;
-				//det["detectObj.objID"] = rescaleBox.objID;
-				det["detectObj.label"] = "HUMAN";
-				det["detectObj.confidence"] = rescaleBox.confidence;
-				//det["detectObj.boxID"] = rescaleBox.boxID;
-
-				// Add the track obj to the trackArray
-				detectArray.push_back(det);
-				// Add the "Track" array to the frame
-				jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["HUMAN"].push_back(det);
-				jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["HUMAN"].push_back(det);		
+				isFirstObj = false;
+
+				w.raw("{\"detectObj.confidence\":"); w.number(det.bbox.confidence);
+				w.raw(",\"detectObj.label\":");      w.string(label);
+				w.raw(",\"detectObj.x1\":");         w.number(det.bbox.x1);
+				w.raw(",\"detectObj.x2\":");         w.number(det.bbox.x2);
+				w.raw(",\"detectObj.y1\":");         w.number(det.bbox.y1);
+				w.raw(",\"detectObj.y2\":");         w.number(det.bbox.y2);
+				w.raw('}');
 			}
-			
-			// RIDER
-			for (int i = 0; i < m_riderBBoxList.size(); i++)
-			{	
-				cout<<"m_riderBBoxList.size() = "<<m_riderBBoxList.size()<<endl;
-				json detectArray;
-				BoundingBox lastBox = m_riderBBoxList[i];
-				BoundingBox rescaleBox(-1, -1, -1, -1, -1);  
-
-				utils::rescaleBBox(
-				lastBox, rescaleBox,
-				m_config->modelWidth, m_config->modelHeight,
-				m_config->frameWidth, m_config->frameHeight);
-
-				string label = "";
-				if(rescaleBox.label==0)
+
+			if (!isFirstObj)
+				w.raw(']');
+		}
+		w.raw('}');
+	}
+
+	// trackObj, groups in key order: "" (unknown label), HUMAN, RIDER, VEHICLE
+	if (!record.trackObjList.empty() && !(SaveToTrackStream && config.trackStreamOnly))
+	{
+		static const int trackLabelOrder[] = {-1, 0, 1, 2};
+		bool isFirstGroup = true;
+
+		w.raw(",\"trackObj\":{");
+		for (int k = 0; k < 4; k++)
+		{
+			const int groupLabel = trackLabelOrder[k];
+			bool isFirstObj = true;
+
+			for (int i = 0; i < record.trackObjList.size(); i++)
+			{
+				const JSON_LOG_TrackRecord& track = record.trackObjList[i];
+				const bool isKnown = (track.label >= 0 && track.label <= 2);
+				if ((groupLabel < 0 && isKnown) || (groupLabel >= 0 && track.label != groupLabel))
+					continue;
+
+				const char* label = trackLabel(track.label);
+				if (isFirstObj)
 				{
-					label = "HUMAN";
-				}
-				else if(rescaleBox.label==1){
-					label = "RIDER";
-				}
-				else if(rescaleBox.label==2){
-					label = "VEHICLE";
-				}
-				else{
-					label = "UNKNOWN";
+					if (!isFirstGroup)
+						w.raw(',');
+					w.string(label);
+					w.raw(":[");
+					isFirstGroup = false;
 				}
-				// Add track obj
-				json det;
-				det["detectObj.x1"] = 	 rescaleBox.x1;
-				det["detectObj.y1"] = 	 rescaleBox.y1;
-				det["detectObj.x2"] = 	 rescaleBox.x2;
-				det["detectObj.y2"] = 	 rescaleBox.y2;
-				//det["detectObj.objID"] = rescaleBox.objID;
-				det["detectObj.label"] = "SMALL_VEHICLE";
-				det["detectObj.confidence"] = rescaleBox.confidence;
-				//det["detectObj.boxID"] = rescaleBox.boxID;
-
-				// Add the track obj to the trackArray
-				detectArray.push_back(det);
-				// Add the "Track" array to the frame
-				jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["SMALL VEHICLE"].push_back(det);
-				jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["SMALL_VEHICLE"].push_back(det);
-			}
-			
-			// // RoadSign
-			// for (int i = 0; i < m_roadSignBBoxList.size(); i++)
-			// {	
-			// 	cout<<"m_roadSignBBoxList.size() = "<<m_roadSignBBoxList.size()<<endl;
-			// 	json detectArray;
-			// 	BoundingBox lastBox = m_roadSignBBoxList[i];
-			// 	BoundingBox rescaleBox(-1, -1, -1, -1, -1);  
-
-			// 	utils::rescaleBBox(
-			// 	lastBox, rescaleBox,
-			// 	m_config->modelWidth, m_config->modelHeight,
-			// 	m_config->frameWidth, m_config->frameHeight);
-
-			// 	string label = "";
-			// 	if(rescaleBox.label==0)
-			// 	{
-			// 		label = "HUMAN";
-			// 	}
-			// 	else if(rescaleBox.label==1){
-			// 		label = "RIDER";
-			// 	}
-			// 	else if(rescaleBox.label==2){
-			// 		label = "VEHICLE";
-			// 	}
-			// 	else{
-			// 		label = "UNKNOWN";
-			// 	}
-			// 	// Add track obj
-			// 	json det;
-			// 	det["detectObj.x1"] = 	 rescaleBox.x1;
-			// 	det["detectObj.y1"] = 	 rescaleBox.y1;
-			// 	det["detectObj.x2"] = 	 rescaleBox.x2;
-			// 	det["detectObj.y2"] = 	 rescaleBox.y2;
-			// 	det["detectObj.objID"] = rescaleBox.objID;
-			// 	det["detectObj.label"] = rescaleBox.label;
-			// 	det["detectObj.confidence"] = rescaleBox.confidence;
-			// 	det["detectObj.boxID"] = rescaleBox.boxID;
-
-			// 	// Add the track obj to the trackArray
-			// 	detectArray.push_back(det);
-			// 	// Add the "Track" array to the frame
-			// // 	jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["ROADSIGN"][std::to_string(i)] = detectArray;
-			// // 	jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["ROADSIGN"][std::to_string(i)] = detectArray;	
-			// 	jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["ROADSIGN"].push_back(det);
-			// 	jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["ROADSIGN"].push_back(det);	
-			
-			// }
-			
-			// StopSign
-			for (int i = 0; i < m_stopSignBBoxList.size(); i++)
-			{	
-				cout<<"m_stopSignBBoxList.size() = "<<m_stopSignBBoxList.size()<<endl;
-				json detectArray;
-				BoundingBox lastBox = m_stopSignBBoxList[i];
-				BoundingBox rescaleBox(-1, -1, -1, -1, -1);  
-
-				utils::rescaleBBox(
-				lastBox, rescaleBox,
-				m_config->modelWidth, m_config->modelHeight,
-				m_config->frameWidth, m_config->frameHeight);
-
-				string label = "";
-				if(rescaleBox.label==0)
+				else
 				{
-					label = "HUMAN";
-				}
-				else if(rescaleBox.label==1){
-					label = "RIDER";
-				}
-				else if(rescaleBox.label==2){
-					label = "VEHICLE";
-				}
-				else{
-					label = "UNKNOWN";
+					w.raw(',');
 				}
-				// Add track obj
-				json det;
-				det["detectObj.x1"] = 	 rescaleBox.x1;
-				det["detectObj.y1"] = 	 rescaleBox.y1;
-				det["detectObj.x2"] = 	 rescaleBox.x2;
-				det["detectObj.y2"] = 	 rescaleBox.y2;
-				//det["detectObj.objID"] = rescaleBox.objID;
-				det["detectObj.label"] = "STOP_SIGN";
-				det["detectObj.confidence"] = rescaleBox.confidence;
-				//det["detectObj.boxID"] = rescaleBox.boxID;
-
-				// Add the track obj to the trackArray
-				detectArray.push_back(det);
-				// Add the "Track" array to the frame
-				jsonData["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["STOPSIGN"].push_back(det);
-				jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["detectObj"]["STOP_SIGN"].push_back(det);	
+				isFirstObj = false;
+
+				w.raw("{\"trackObj.bbox.label\":");        w.string(label);
+				w.raw(",\"trackObj.distanceToCamera\":");  w.number(track.distanceToCamera);
+				w.raw(",\"trackObj.x1\":");                w.number(track.bbox.x1);
+				w.raw(",\"trackObj.x2\":");                w.number(track.bbox.x2);
+				w.raw(",\"trackObj.y1\":");                w.number(track.bbox.y1);
+				w.raw(",\"trackObj.y2\":");                w.number(track.bbox.y2);
+				w.raw(",\"trackedObj.id\":");              w.number(track.id);
+				w.raw('}');
 			}
-			
-		// }
+
+			if (!isFirstObj)
+				w.raw(']');
+		}
+		w.raw('}');
 	}
-	
-	if(SaveTrackObjLog)
+
+	// vanishLineY
+	if (SaveVanishLineLog)
 	{
-		for (int i = 0; i < m_trackedObjList.size(); i++)
-		{   // Create an "Track" array for each frame	
-			json trackArray;
-			const Object& trackedObj = m_trackedObjList[i];
-			if (trackedObj.bboxList.empty())
-				continue;
-			BoundingBox lastBox = trackedObj.bboxList.back();
-			BoundingBox rescaleBox(-1, -1, -1, -1, -1);
-
-			// Rescale BBoxes
-			//#ifdef SAV837
-			utils::rescaleBBox(
-			lastBox, rescaleBox,
-			m_config->modelWidth, m_config->modelHeight,
-			m_config->frameWidth, m_config->frameHeight);
-			//#endif
-			string label = "";
-			if(lastBox.label==0)
-			{
-				label = "HUMAN";
-			}
-			else if(lastBox.label==1)
+		w.raw(",\"vanishLineY\":[{\"vanishlineY\":");
+		w.number(record.yVanish);
+		w.raw("}]");
+	}
+
+	w.raw("}}}");
+}
+
+// ============================================
+//                Writer Thread
+// ============================================
+void JSON_LOG::PushFrameRecord(JSON_LOG_FrameRecord& record)
+{
+	if (!writerQueue->tryPush(record))
+	{
+		if (config.queuePolicy == JSON_LOG_QUEUE_BLOCK)
+		{
+			// Sleep until the writer frees a slot, it signals after each pop.
+			// Without a running writer no slot ever frees up: drop the record.
+			std::unique_lock<std::mutex> lock(writerMutex);
+			while (!writerQueue->tryPush(record))
 			{
-				label = "RIDER";
+				if (writerTerminated)
+				{
+					droppedRecords++;
+					return;
+				}
+				writerCondition.notify_all();
+				writerCondition.wait(lock);
 			}
-			else if(lastBox.label==2)
+		}
+		else
+		{
+			// Drop the oldest record. If the writer is still reading the slot
+			// we would reuse, the new record is dropped instead.
+			if (writerQueue->tryPop(droppedRecord))
+				droppedRecords++;
+
+			if (!writerQueue->tryPush(record))
+				droppedRecords++;
+		}
+	}
+
+	writerCondition.notify_one();
+}
+
+void JSON_LOG::StartWriterThread()
+{
+	if (writerQueue != nullptr)
+		return;
+
+	writerQueue = new RingBuffer<JSON_LOG_FrameRecord>(config.queueCapacity);
+	writerTerminated = false;
+	writerThread = std::thread(&JSON_LOG::RunWriterFunc, this);
+}
+
+void JSON_LOG::StopWriterThread()
+{
+	if (writerQueue == nullptr)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		writerTerminated = true;
+	}
+	writerCondition.notify_all();
+
+	if (writerThread.joinable())
+		writerThread.join();
+
+	delete writerQueue;
+	writerQueue = nullptr;
+}
+
+void JSON_LOG::RunWriterFunc()
+{
+	JSON_LOG_FrameRecord record;
+
+	while (true)
+	{
+		if (writerQueue->tryPop(record))
+		{
+			// A producer blocked on a full queue checks under writerMutex
 			{
-				label = "VEHICLE";
+				std::lock_guard<std::mutex> lock(writerMutex);
 			}
-			// Add track obj
-			json track;
-			track["trackObj.x1"] = 	 rescaleBox.x1;
-			track["trackObj.y1"] = 	 rescaleBox.y1;
-			track["trackObj.x2"] = 	 rescaleBox.x2;
-			track["trackObj.y2"] = 	 rescaleBox.y2;
-			// track["trackObj.status"] = trackedObj.status;
-			track["trackObj.distanceToCamera"] = round(trackedObj.distanceToCamera);
-			track["trackObj.bbox.label"] = label;
-			track["trackedObj.id"] = trackedObj.id;
-
-			// Add the track obj to the trackArray
-			trackArray.push_back(track);
-			// Add the "Track" array to the frame
-			jsonData["frame_ID"][std::to_string(m_frameIdx)]["trackObj"][label].push_back(track);
-			jsonDataCurrentFrame["frame_ID"][std::to_string(m_frameIdx)]["trackObj"][label].push_back(track);
+			writerCondition.notify_all();
 
+			WriteFrameRecord(record);
+			writtenRecords++;
+			continue;
 		}
+
+		// Queue is drained, leave only after termination was requested
+		if (writerTerminated)
+			break;
+
+		std::unique_lock<std::mutex> lock(writerMutex);
+		writerCondition.wait_for(lock, std::chrono::milliseconds(10),
+			[this] { return writerTerminated || !writerQueue->empty(); });
 	}
+}
 
-    // Convert the JSON object to a string with indentation
-	if(ShowJsonLog)
+// ============================================
+//                  Black Box
+// ============================================
+static void reserveBlackBoxRecords(std::vector<JSON_LOG_FrameRecord>& records)
+{
+	for (int i = 0; i < records.size(); i++)
 	{
-	std::string jsonString = jsonData.dump(4);
-	std::string jsonCurrentFrameString = jsonDataCurrentFrame.dump(4);
-	cout<<"===================================================================================="<<endl;
-	cout<<jsonCurrentFrameString<<endl;
-	cout<<"===================================================================================="<<endl;
+		records[i].detectObjList.reserve(JSON_LOG_BLACK_BOX_RESERVED_OBJECTS);
+		records[i].trackObjList.reserve(JSON_LOG_BLACK_BOX_RESERVED_OBJECTS);
 	}
-    
-	std::string jsonString = jsonData.dump(4);
-	std::string jsonCurrentFrameString = jsonDataCurrentFrame.dump(4);
-	if(SaveToJSONFile)
+}
+
+void JSON_LOG::StartBlackBox()
+{
+	if (isBlackBox)
+		return;
+
+	int preFrames = std::max(1, config.blackBoxPreFrames);
+	int postFrames = std::max(0, config.blackBoxPostFrames);
+
+	// An event window is the frames before the event plus the frames after it
+	blackBoxRing.resize(preFrames);
+	blackBoxBatch.resize(preFrames + postFrames);
+	blackBoxDumpBatch.resize(preFrames + postFrames);
+	reserveBlackBoxRecords(blackBoxRing);
+	reserveBlackBoxRecords(blackBoxBatch);
+	reserveBlackBoxRecords(blackBoxDumpBatch);
+
+	blackBoxRingCount = 0;
+	blackBoxBatchSize = 0;
+	blackBoxPostRemaining = 0;
+	blackBoxDumpSize = 0;
+	blackBoxTerminated = false;
+	blackBoxThread = std::thread(&JSON_LOG::RunBlackBoxFunc, this);
+	isBlackBox = true;
+
+	JSON_LOG_PRINT(JSON_LOG_LEVEL_INFO, "[JSON_LOG] Black box mode: " << preFrames << " frames before and "
+				   << postFrames << " frames after LDW / FCW events are saved to " << jsonFile);
+}
+
+void JSON_LOG::StopBlackBox()
+{
+	if (!isBlackBox)
+		return;
+
+	// Save the window still being collected, cut short
+	if (blackBoxBatchSize > 0)
+		SubmitBlackBoxBatch();
+
 	{
-		SaveJsonLogFile(jsonString);
+		std::lock_guard<std::mutex> lock(blackBoxMutex);
+		blackBoxTerminated = true;
 	}
-	return jsonCurrentFrameString;
+	blackBoxCondition.notify_all();
+
+	if (blackBoxThread.joinable())
+		blackBoxThread.join();
+
+	isBlackBox = false;
 }
-void JSON_LOG::SaveJsonLogFile(std::string jsonString)
+
+void JSON_LOG::PushBlackBoxRecord(JSON_LOG_FrameRecord& record)
 {
-	// Write the updated JSON to the file
-    std::ofstream outFile(jsonFile);
-    if (outFile.is_open()) {
-        outFile << jsonString;  // Adjust the indentation as needed
-        outFile.close();
-        std::cout << "Additional frame IDs appended to the JSON file.\n";
-    } else {
-        std::cerr << "Unable to open the file for writing.\n";
-        //return 1;
-    }
+	bool isEvent = (record.eventType == ADAS_EVENT_LDW
+					|| record.eventType == ADAS_EVENT_FCW
+					|| record.eventType == ADAS_EVENT_LDW_FCW);
+
+	// Collecting the frames after an event, another event extends the window
+	if (blackBoxPostRemaining > 0)
+	{
+		std::swap(blackBoxBatch[blackBoxBatchSize++], record);
+
+		if (isEvent)
+			blackBoxPostRemaining = config.blackBoxPostFrames;
+		else
+			blackBoxPostRemaining--;
 
+		if (blackBoxPostRemaining == 0 || blackBoxBatchSize == blackBoxBatch.size())
+			SubmitBlackBoxBatch();
+		return;
+	}
+
+	// No event yet: overwrite the oldest frame of the ring
+	const uint64_t ringSize = blackBoxRing.size();
+	std::swap(blackBoxRing[blackBoxRingCount % ringSize], record);
+	blackBoxRingCount++;
+
+	if (!isEvent)
+		return;
+
+	// Event: the frames of the ring open the window, oldest first
+	uint64_t numFrames = std::min(blackBoxRingCount, ringSize);
+	for (uint64_t i = blackBoxRingCount - numFrames; i < blackBoxRingCount; i++)
+		std::swap(blackBoxBatch[blackBoxBatchSize++], blackBoxRing[i % ringSize]);
+
+	blackBoxRingCount = 0;
+	blackBoxEvents++;
+
+	JSON_LOG_PRINT(JSON_LOG_LEVEL_INFO, "[JSON_LOG] Black box event at frame " << blackBoxBatch[blackBoxBatchSize - 1].frameIdx);
+
+	// Frames before the event go to disk right away, the rest follow
+	SubmitBlackBoxBatch();
+	blackBoxPostRemaining = config.blackBoxPostFrames;
 }
-std::string JSON_LOG::GetJsonValueByKey(int targetFrameID)
+
+// Hand the collected window over to the dump thread. Waits only if the
+// previous window is still being written, i.e. for back-to-back events.
+void JSON_LOG::SubmitBlackBoxBatch()
 {
-	// Read existing JSON file
-    std::ifstream inFile(jsonFile);
-    json jsonData;
-	std::string frameIDJsonString = "";
-    if (inFile.is_open()) {
-        inFile >> jsonData;
-        inFile.close();
-    } else {
-        std::cerr << "Unable to open the file.\n";
-        return "FILE_OPEN_FAILED";
-    }
+	std::unique_lock<std::mutex> lock(blackBoxMutex);
+	blackBoxCondition.wait(lock, [this] { return blackBoxDumpSize == 0; });
 
-	// Specify the frame ID you want to retrieve
-    // int targetFrameID = 2;
+	std::swap(blackBoxBatch, blackBoxDumpBatch);
+	blackBoxDumpSize = blackBoxBatchSize;
+	blackBoxBatchSize = 0;
 
-    // Check if the frame ID exists in the JSON
-    if (jsonData["frame_ID"].contains(std::to_string(targetFrameID))) {
-        // Retrieve the "Obj" array for the specified frame ID
-        json objArray = jsonData["frame_ID"][std::to_string(targetFrameID)];
+	lock.unlock();
+	blackBoxCondition.notify_all();
+}
 
-        // Print the values for each object in the "Obj" array
-        // for (const auto& obj : objArray) {
-        //     std::cout << "Vanish: " << obj["x"] << ", y: " << obj["y"]
-        //               << ", w: " << obj["w"] << ", h: " << obj["h"]
-        //               << ", label: " << obj["label"] << "\n";
-        // }
-		std::string frameIDJsonString = objArray.dump(4);
-		cout<<"================ targetFrameID = "<<targetFrameID<<"======================="<<endl;
-		cout<<frameIDJsonString<<endl;
-		cout<<"========================================================="<<endl;
-    } else {
-        std::cerr << "Frame ID " << targetFrameID << " not found in the JSON.\n";
-        return "FRAME_ID_NOT_FOUND_ERROR";
-    }
-	// std::string frameIDJsonString = objArray.dump(4);
-    return frameIDJsonString;
+void JSON_LOG::RunBlackBoxFunc()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(blackBoxMutex);
+		blackBoxCondition.wait(lock, [this] { return blackBoxTerminated || blackBoxDumpSize > 0; });
+
+		// Leave only after the last window was saved
+		if (blackBoxDumpSize == 0)
+			break;
+
+		int numRecords = blackBoxDumpSize;
+		lock.unlock();
+
+		for (int i = 0; i < numRecords; i++)
+		{
+			WriteFrameRecord(blackBoxDumpBatch[i]);
+			writtenRecords++;
+		}
+		Flush();
+
+		lock.lock();
+		blackBoxDumpSize = 0;
+		lock.unlock();
+		blackBoxCondition.notify_all();
+	}
 }
-std::string JSON_LOG::GetJSONFile()
+
+uint64_t JSON_LOG::GetBlackBoxEvents()
 {
-    return jsonFile;
-};
+	return blackBoxEvents;
+}
+
+void JSON_LOG::SetLogLevel(int level)
+{
+	logLevel = level;
+}
+
+int JSON_LOG::GetLogLevel()
+{
+	return logLevel;
+}
+
+void JSON_LOG::SetFrameMemoryResource(std::pmr::memory_resource* resource)
+{
+	detectTable.setMemoryResource(resource);
+}
+
+uint64_t JSON_LOG::GetWrittenRecords()
+{
+	return writtenRecords;
+}
+
+uint64_t JSON_LOG::GetDroppedRecords()
+{
+	return droppedRecords;
+}
+
+// ============================================
+//              Offline Converter
+// ============================================
+bool JSON_LOG::ForEachFrameView(const std::function<bool(const JSON_LOG_FrameView&)>& callback)
+{
+	// Records still in the stdio buffer are not visible through the mapping
+	FlushStreamFile(false);
+
+	JSON_LOG_Reader reader;
+	if (!reader.Open(jsonFile))
+		return false;
+
+	JSON_LOG_FrameView frame;
+	while (reader.NextFrame(frame))
+	{
+		if (!callback(frame))
+			break;
+	}
+
+	if (reader.IsTruncated())
+		std::cerr << "Truncated record at the end of " << jsonFile << "\n";
+	return true;
+}
+
+bool JSON_LOG::ForEachFrame(const std::function<bool(int frameIdx, const json& frame)>& callback)
+{
+	json frameJson;
+	return ForEachFrameView([&](const JSON_LOG_FrameView& frame)
+	{
+		if (!JSON_LOG_Reader::ParseFrame(frame, frameJson))
+		{
+			std::cerr << "Unable to parse frame " << frame.frameIdx << "\n";
+			return true;
+		}
+		return callback(frame.frameIdx, frameJson);
+	});
+}
+
+int JSON_LOG::FilterFrames(const std::string& query, std::ostream& out, bool emitFrames)
+{
+	JSON_LOG_FilterQuery filterQuery;
+	if (!filterQuery.Parse(query))
+	{
+		std::cerr << "Invalid filter query: " << query << "\n";
+		return -1;
+	}
+	filterQuery.emitFrames = emitFrames;
+
+	// Records still in the stdio buffer are not visible through the mapping
+	FlushStreamFile(false);
+
+	JSON_LOG_Filter filter(filterQuery);
+	if (!filter.Run(jsonFile, out))
+		return -1;
+
+	return filter.GetNumMatches();
+}
+
+bool JSON_LOG::ConvertBinaryLog(const std::string& binaryFile, const std::string& outFile, bool jsonLines)
+{
+	JSON_LOG_Reader reader;
+	if (!reader.Open(binaryFile))
+		return false;
+
+	if (reader.GetLayout() != JSON_LOG_READER_BINARY)
+	{
+		std::cerr << "Not a binary JSON log: " << binaryFile << "\n";
+		return false;
+	}
+
+	std::ofstream out(outFile);
+	if (!out.is_open())
+	{
+		std::cerr << "Unable to open the file for writing: " << outFile << "\n";
+		return false;
+	}
+
+	json jsonData;
+	json frameJson;
+	JSON_LOG_FrameView frame;
+	int numRecords = 0;
+
+	while (reader.NextFrame(frame))
+	{
+		if (!JSON_LOG_Reader::ParseFrame(frame, frameJson))
+		{
+			std::cerr << "Corrupted record after " << numRecords << " frames\n";
+			break;
+		}
+		numRecords++;
+
+		if (jsonLines)
+		{
+			json record;
+			record["frame_ID"][std::to_string(frame.frameIdx)] = std::move(frameJson);
+			out << record.dump() << "\n";
+			continue;
+		}
+
+		jsonData["frame_ID"][std::to_string(frame.frameIdx)] = std::move(frameJson);
+	}
+
+	// Last record was cut off (e.g. power loss while recording)
+	if (reader.IsTruncated())
+		std::cerr << "Truncated record after " << numRecords << " frames\n";
+
+	if (!jsonLines)
+		out << jsonData.dump(4);
+
+	std::cout << "Converted " << numRecords << " frames to " << outFile << "\n";
+	return true;
+}
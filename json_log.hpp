@@ -24,6 +24,13 @@
 #include <cmath>
 #include <vector>
 #include <assert.h>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
 
 #include "opencv2/core.hpp"
 #include "opencv2/imgproc.hpp"
@@ -33,40 +40,301 @@
 #include "dataStructures.h"
 #include "adas.hpp"
 #include "bounding_box.hpp"
+#include "ring_buffer.hpp"
+#include "json_record_writer.hpp"
+#include "json_log_reader.hpp"
+#include "json_log_filter.hpp"
+#include "bbox_rescale.hpp"
+#include "detection_table.hpp"
+#include "track_delta_codec.hpp"
 using namespace std;
 
+// Flush policy of the streaming (JSON Lines) frame log
+enum JSON_LOG_FLUSH_POLICY
+{
+	JSON_LOG_FLUSH_NONE,   // Leave buffering to stdio and the OS page cache
+	JSON_LOG_FLUSH_FRAME,  // fflush() every flushInterval records
+	JSON_LOG_FLUSH_FSYNC   // fflush() + fsync() every flushInterval records
+};
+
+// Encoding of the stream file records
+enum JSON_LOG_FORMAT
+{
+	JSON_LOG_FORMAT_JSON,     // JSON Lines, one compact object per line
+	JSON_LOG_FORMAT_CBOR,     // Length-prefixed CBOR records
+	JSON_LOG_FORMAT_MSGPACK   // Length-prefixed MessagePack records
+};
+
+// Binary log layout: 8 byte header ("JLOG", version, format, 2 reserved)
+// followed by records of [uint32 little-endian length][payload]
+#define JSON_LOG_BINARY_MAGIC "JLOG"
+#define JSON_LOG_BINARY_VERSION 1
+#define JSON_LOG_BINARY_HEADER_SIZE 8
+
+// Sidecar index (<log file>.idx) written next to stream logs: one 16 byte
+// little-endian entry {int32 frameIdx, uint32 length, uint64 offset} per record
+#define JSON_LOG_INDEX_SUFFIX ".idx"
+#define JSON_LOG_INDEX_ENTRY_SIZE 16
+
+// Tracked object stream (<log file>.trk) written next to stream logs, see
+// TrackDeltaEncoder for the layout
+#define JSON_LOG_TRACK_SUFFIX ".trk"
+
+struct JSON_LOG_IndexEntry
+{
+	int32_t frameIdx = 0;
+	uint32_t length = 0;   // Record payload size in bytes
+	uint64_t offset = 0;   // Byte offset of the payload in the log file
+};
+
+// Terminal verbosity, a message is printed when its level is <= the current level
+enum JSON_LOG_LEVEL
+{
+	JSON_LOG_LEVEL_NONE = 0,
+	JSON_LOG_LEVEL_ERROR,   // Failures
+	JSON_LOG_LEVEL_INFO,    // Once per run (open, close, conversions)
+	JSON_LOG_LEVEL_DEBUG,   // Once per frame (full frame record)
+	JSON_LOG_LEVEL_TRACE    // Once per object
+};
+
+// Highest level compiled in. Prints above it are removed at compile time,
+// release builds keep nothing on the per-frame / per-object path.
+#ifndef JSON_LOG_MAX_LEVEL
+#ifdef NDEBUG
+#define JSON_LOG_MAX_LEVEL JSON_LOG_LEVEL_INFO
+#else
+#define JSON_LOG_MAX_LEVEL JSON_LOG_LEVEL_TRACE
+#endif
+#endif
+
+// Print from a JSON_LOG member: JSON_LOG_PRINT(JSON_LOG_LEVEL_DEBUG, "a = " << a);
+#define JSON_LOG_PRINT(level, message)                                      \
+	do {                                                                    \
+		if constexpr ((level) <= JSON_LOG_MAX_LEVEL) {                      \
+			if ((level) <= logLevel.load(std::memory_order_relaxed))        \
+				std::cout << message << std::endl;                          \
+		}                                                                   \
+	} while (0)
+
+// What the producer does when the writer queue is full
+enum JSON_LOG_QUEUE_POLICY
+{
+	JSON_LOG_QUEUE_DROP_OLDEST,  // Discard the oldest queued record (counted)
+	JSON_LOG_QUEUE_BLOCK         // Wait until the writer thread frees a slot
+};
+
+// Detected object classes of the frame record, in the order of the
+// bounding box lists passed to JsonLogString_2 / LogFrame (same as DETECT_CLASS)
+enum JSON_LOG_DETECT_CLASS
+{
+	JSON_LOG_DETECT_HUMAN = DETECT_CLASS_HUMAN,
+	JSON_LOG_DETECT_SMALL_VEHICLE = DETECT_CLASS_RIDER,
+	JSON_LOG_DETECT_VEHICLE = DETECT_CLASS_VEHICLE,
+	JSON_LOG_DETECT_ROAD_SIGN = DETECT_CLASS_ROAD_SIGN,
+	JSON_LOG_DETECT_STOP_SIGN = DETECT_CLASS_STOP_SIGN,
+	JSON_LOG_DETECT_NUM_CLASSES = DETECT_NUM_CLASSES
+};
+
+// Logger settings, filled once by the owner (see ADAS::_initJsonLog)
+struct JSON_LOG_Config_S
+{
+	int logLevel = JSON_LOG_LEVEL_INFO;  // JSON_LOG_LEVEL_DEBUG prints every frame record
+	bool saveToFile = false;    // Save frame records to the log file
+	bool streamMode = true;     // Append records instead of rewriting one document
+	int format = JSON_LOG_FORMAT_JSON;
+	int flushPolicy = JSON_LOG_FLUSH_FRAME;
+	int flushInterval = 1;
+
+	// Background writer thread
+	bool asyncWrite = false;
+	int queueCapacity = 64;
+	int queuePolicy = JSON_LOG_QUEUE_DROP_OLDEST;
+
+	// Black box: keep the latest frame records in memory and save only the
+	// frames around LDW / FCW events, on a background thread (needs saveToFile,
+	// replaces asyncWrite)
+	bool blackBoxMode = false;
+	int blackBoxPreFrames = 150;   // Frames saved before an event (5 s at 30 FPS)
+	int blackBoxPostFrames = 90;   // Frames saved after the last event (3 s at 30 FPS)
+
+	// Tracked objects as a delta coded stream (needs streamMode)
+	bool saveTrackStream = false;
+	bool trackStreamOnly = false;  // Leave trackObj out of the frame records
+	int trackKeyframeInterval = TRACK_DELTA_DEFAULT_KEYFRAME_INTERVAL;
+	int trackQuantStep = 1;        // Pixels per coordinate unit, > 1 is lossy
+};
+
+// Objects per black box record allocated up front, more grow the record once
+#define JSON_LOG_BLACK_BOX_RESERVED_OBJECTS 16
+
+// Compact per-frame snapshot handed to the writer thread.
+// Boxes are already rescaled to frame size, nothing here refers to ADAS state.
+struct JSON_LOG_DetectRecord
+{
+	int classIdx = JSON_LOG_DETECT_VEHICLE;
+	BoundingBox bbox = BoundingBox(-1, -1, -1, -1, -1);
+};
+
+struct JSON_LOG_TrackRecord
+{
+	int label = -1;
+	BoundingBox bbox = BoundingBox(-1, -1, -1, -1, -1);
+	decltype(Object::distanceToCamera) distanceToCamera = 0;
+	decltype(Object::id) id = 0;
+};
+
+struct JSON_LOG_FrameRecord
+{
+	int frameIdx = 0;
+	int eventType = 0;
+	decltype(ADAS_Results::yVanish) yVanish = 0;
+	decltype(ADAS_Results::isDetectLine) isDetectLine = false;
+	decltype(ADAS_Results::pLeftFar) pLeftFar;
+	decltype(ADAS_Results::pLeftCarhood) pLeftCarhood;
+	decltype(ADAS_Results::pRightFar) pRightFar;
+	decltype(ADAS_Results::pRightCarhood) pRightCarhood;
+	std::vector<JSON_LOG_DetectRecord> detectObjList;
+	std::vector<JSON_LOG_TrackRecord> trackObjList;
+};
+
 class JSON_LOG
 {
 public:
 	JSON_LOG(std::string file);
+	JSON_LOG(std::string file, const JSON_LOG_Config_S& config);
 	~JSON_LOG();
-	// Return LOG String with JSON format
-	std::string JsonLogString(ADAS_Results adasResult,
+
+	// Lifecycle: open the log file once, flush on demand, close on destruction
+	bool Open();
+	void Flush();
+	void Close();
+	// Log one frame like LogFrame, return it as one compact JSON line.
+	// boundingBoxLists in JSON_LOG_DETECT_CLASS order.
+	std::string JsonLogString(const ADAS_Results& adasResult,
 							  ADAS_Config_S* m_config,
-							  std::vector<BoundingBox> boundingBoxLists[],
-							  std::vector<Object> m_trackedObjList,
+							  const std::vector<BoundingBox>* const (&boundingBoxLists)[JSON_LOG_DETECT_NUM_CLASSES],
+							  const std::vector<Object>& m_trackedObjList,
 							  int m_frameIdx);
 
-
-	std::string JsonLogString_2(ADAS_Results adasResult,
+	// Same, one list per class. Returns the frame as one compact JSON line.
+	std::string JsonLogString_2(const ADAS_Results& adasResult,
 							  ADAS_Config_S* m_config,
-							  std::vector<BoundingBox> m_humanBBoxList,
-							  std::vector<BoundingBox> m_riderBBoxList,
-							  std::vector<BoundingBox> m_vehicleBBoxList,
-							  std::vector<BoundingBox> m_roadSignBBoxList,
-							  std::vector<BoundingBox> m_stopSignBBoxList,
-							  std::vector<Object> m_trackedObjList,
+							  const std::vector<BoundingBox>& m_humanBBoxList,
+							  const std::vector<BoundingBox>& m_riderBBoxList,
+							  const std::vector<BoundingBox>& m_vehicleBBoxList,
+							  const std::vector<BoundingBox>& m_roadSignBBoxList,
+							  const std::vector<BoundingBox>& m_stopSignBBoxList,
+							  const std::vector<Object>& m_trackedObjList,
 							  int m_frameIdx);
 
+	// Log one frame. With asyncWrite the frame is queued as a snapshot and
+	// serialization and file I/O happen on the writer thread.
+	void LogFrame(const ADAS_Results& adasResult,
+				  ADAS_Config_S* m_config,
+				  const std::vector<BoundingBox>& m_humanBBoxList,
+				  const std::vector<BoundingBox>& m_riderBBoxList,
+				  const std::vector<BoundingBox>& m_vehicleBBoxList,
+				  const std::vector<BoundingBox>& m_roadSignBBoxList,
+				  const std::vector<BoundingBox>& m_stopSignBBoxList,
+				  const std::vector<Object>& m_trackedObjList,
+				  int m_frameIdx);
+
+	// Same with boxes already rescaled to frame size (per-frame tables of ADAS):
+	// trackBoxes[i] is the rescaled last box of m_trackedObjList[i]
+	void LogFrame(const ADAS_Results& adasResult,
+				  const DetectionTable& detections,
+				  const std::vector<BoundingBox>& trackBoxes,
+				  const std::vector<Object>& m_trackedObjList,
+				  int m_frameIdx);
+
 	void SaveJsonLogFile(std::string jsonString);
 
 	std::string GetJsonValueByKey(int targetFrameID);
 
 	std::string GetJSONFile();
 
+	// Streaming mode: append one compact JSON record per frame (JSON Lines)
+	// to an open file instead of re-reading and rewriting the whole document.
+	// Queued records are written first, an existing log of another format
+	// is moved to <file>.<n>.
+	bool EnableStreamMode(int policy = JSON_LOG_FLUSH_FRAME, int interval = 1,
+						  int format = JSON_LOG_FORMAT_JSON);
+	void FlushStreamFile(bool sync);
+	void CloseStreamFile();
+
+	// Runtime verbosity, capped by JSON_LOG_MAX_LEVEL
+	void SetLogLevel(int level);
+	int GetLogLevel();
+
+	// Per-frame scratch memory (e.g. the FrameArena of ADAS) for the detection
+	// table of JsonLogString_2 / LogFrame. Frame records never use it, they
+	// may still be queued for the writer thread when the frame is over.
+	void SetFrameMemoryResource(std::pmr::memory_resource* resource);
+
+	// Writer thread statistics
+	uint64_t GetWrittenRecords();
+	uint64_t GetDroppedRecords();
+
+	// Black box statistics: events that opened a new window of saved frames
+	uint64_t GetBlackBoxEvents();
+
+	// Offline: walk every frame of the log file through a read-only mapping.
+	// The view is valid during the callback only, return false to stop.
+	bool ForEachFrameView(const std::function<bool(const JSON_LOG_FrameView&)>& callback);
+	bool ForEachFrame(const std::function<bool(int frameIdx, const nlohmann::json& frame)>& callback);
+
+	// Offline: write the entries (or whole frames) matching a query such as
+	// "ADAS.FCW==1" or "trackObj.distanceToCamera<10" as JSON Lines.
+	// Returns the number of matches, -1 on error.
+	int FilterFrames(const std::string& query, std::ostream& out, bool emitFrames = false);
+
+	// Offline: convert a binary (CBOR / MessagePack) log back to the JSON
+	// document layout {"frame_ID": {...}}, or to JSON Lines
+	static bool ConvertBinaryLog(const std::string& binaryFile,
+								 const std::string& outFile,
+								 bool jsonLines = false);
+
 private:
-	//Show log on terminal
-	bool ShowJsonLog = true;
+	bool OpenStreamFile(int policy, int interval, int format);
+	void ReleaseStreamFile();
+	void AppendStreamRecord(const char* data, size_t size, int frameIdx);
+	bool OpenTrackStream();
+	void WriteTrackRecord(const JSON_LOG_FrameRecord& record);
+
+	// Frame index
+	bool LoadFrameIndex();
+	bool FindFrameRecord(int targetFrameID, JSON_LOG_IndexEntry& entry);
+	bool ReadFrameRecord(const JSON_LOG_IndexEntry& entry, std::string& record, int& format);
+
+	// Frame record
+	// ratio == nullptr: detections and trackBoxes are already rescaled
+	void BuildFrameRecord(const ADAS_Results& adasResult,
+						  const bboxUtil::RescaleRatio* ratio,
+						  const DetectionTable& detections,
+						  const std::vector<BoundingBox>* trackBoxes,
+						  const std::vector<Object>& m_trackedObjList,
+						  int m_frameIdx,
+						  JSON_LOG_FrameRecord& record);
+	void SubmitFrameRecord();
+	nlohmann::json FrameRecordToJson(const JSON_LOG_FrameRecord& record);
+	void SerializeFrameRecord(const JSON_LOG_FrameRecord& record, std::string& out);
+	void WriteFrameRecord(const JSON_LOG_FrameRecord& record);
+	void PushFrameRecord(JSON_LOG_FrameRecord& record);
+
+	// Writer thread
+	void StartWriterThread();
+	void StopWriterThread();
+	void RunWriterFunc();
+
+	// Black box
+	void StartBlackBox();
+	void StopBlackBox();
+	void PushBlackBoxRecord(JSON_LOG_FrameRecord& record);
+	void SubmitBlackBoxBatch();
+	void RunBlackBoxFunc();
+
+	//Terminal verbosity (JSON_LOG_LEVEL), read by the writer thread too
+	std::atomic<int> logLevel{JSON_LOG_LEVEL_INFO};
 
 	//Enable save log type
 	bool SaveTrackObjLog = true;
@@ -76,9 +344,66 @@ private:
 	bool SaveToJSONFile = false;
 	bool SaveLDWLog = true;
 	bool SaveFCWLog = true;
+	bool SaveToStreamFile = false;
+	bool SaveToTrackStream = false;
 	
 	std::string jsonString;
 	std::string jsonFile;
+	std::string frameKey;  // Reused frame ID key buffer
+	JSON_LOG_Config_S config;
+
+	// Streaming mode
+	FILE* streamFile = nullptr;
+	int flushPolicy = JSON_LOG_FLUSH_FRAME;
+	int flushInterval = 1;
+	int unflushedRecords = 0;
+	std::mutex fileMutex;
+	uint64_t streamOffset = 0;    // Size of the stream file
+	uint64_t flushedOffset = 0;   // Bytes handed to the OS so far
+
+	// Frame index (guarded by fileMutex)
+	FILE* indexFile = nullptr;
+	std::unordered_map<int, JSON_LOG_IndexEntry> frameIndex;
+	bool isIndexLoaded = false;
+	bool isIndexed = false;
+	int readFd = -1;
+	int readFormat = JSON_LOG_FORMAT_JSON;  // Record format of the indexed file (header)
+	std::string recordBuffer;  // Reused by the serializer (writer side only)
+	std::vector<uint8_t> binaryBuffer;
+
+	// Tracked object stream (file guarded by fileMutex, the rest writer side only)
+	FILE* trackFile = nullptr;
+	TrackDeltaEncoder* trackEncoder = nullptr;
+	TrackDeltaFrame trackFrame;
+	std::vector<uint8_t> trackBuffer;
+
+	// Writer thread
+	RingBuffer<JSON_LOG_FrameRecord>* writerQueue = nullptr;
+	std::thread writerThread;
+	std::mutex writerMutex;
+	std::condition_variable writerCondition;
+	std::atomic<bool> writerTerminated{false};
+	std::atomic<uint64_t> writtenRecords{0};
+	std::atomic<uint64_t> droppedRecords{0};
+	JSON_LOG_FrameRecord pendingRecord;   // Producer side, reused every frame
+	DetectionTable detectTable;           // Lists of JsonLogString_2 / LogFrame, reused every frame
+	JSON_LOG_FrameRecord droppedRecord;   // Producer side, receives dropped records
+
+	// Black box. Records are swapped between the ring and the batches, so
+	// their lists keep the capacity and steady state allocates nothing.
+	bool isBlackBox = false;
+	std::vector<JSON_LOG_FrameRecord> blackBoxRing;       // Latest frames before any event (producer)
+	uint64_t blackBoxRingCount = 0;                       // Frames pushed since the ring was emptied
+	std::vector<JSON_LOG_FrameRecord> blackBoxBatch;      // Event window being collected (producer)
+	int blackBoxBatchSize = 0;
+	int blackBoxPostRemaining = 0;                        // > 0 while collecting frames after an event
+	std::vector<JSON_LOG_FrameRecord> blackBoxDumpBatch;  // Event window being saved (dump thread)
+	int blackBoxDumpSize = 0;                             // Guarded by blackBoxMutex, 0 when idle
+	bool blackBoxTerminated = false;                      // Guarded by blackBoxMutex
+	std::thread blackBoxThread;
+	std::mutex blackBoxMutex;
+	std::condition_variable blackBoxCondition;
+	std::atomic<uint64_t> blackBoxEvents{0};
 };
 
 #endif
\ No newline at end of file
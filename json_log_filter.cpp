@@ -0,0 +1,318 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "json_log_filter.hpp"
+#include "json_log_reader.hpp"
+#include "json_log.hpp"
+
+using json = nlohmann::json;
+
+// ============================================
+//                 SAX Handler
+// ============================================
+
+// Follows {"frame_ID": {"N": {...}, ...}} and builds a DOM for one frame at a
+// time: events below frame_ID -> N go to a DOM parser that is handed to the
+// filter and dropped as soon as the frame object is closed.
+class FrameFilterSax : public nlohmann::json_sax<json>
+{
+public:
+	explicit FrameFilterSax(JSON_LOG_Filter& filter) : m_filter(filter) {}
+
+	bool null() override { return !m_dom || m_dom->null(); }
+	bool boolean(bool val) override { return !m_dom || m_dom->boolean(val); }
+	bool number_integer(number_integer_t val) override { return !m_dom || m_dom->number_integer(val); }
+	bool number_unsigned(number_unsigned_t val) override { return !m_dom || m_dom->number_unsigned(val); }
+	bool number_float(number_float_t val, const string_t& s) override { return !m_dom || m_dom->number_float(val, s); }
+	bool string(string_t& val) override { return !m_dom || m_dom->string(val); }
+	bool binary(binary_t& val) override { return !m_dom || m_dom->binary(val); }
+
+	bool start_object(std::size_t len) override
+	{
+		m_depth++;
+		if (m_depth == 3 && m_isInFrames)
+		{
+			m_frame = json();
+			m_dom.reset(new nlohmann::detail::json_sax_dom_parser<json>(m_frame, false));
+		}
+		return !m_dom || m_dom->start_object(len);
+	}
+
+	bool end_object() override
+	{
+		bool ret = !m_dom || m_dom->end_object();
+		if (m_depth == 3 && m_dom)
+		{
+			m_dom.reset();
+			m_filter.OnFrame(m_frameIdx, m_frame);
+			m_frame = json();
+		}
+		else if (m_depth == 2)
+		{
+			m_isInFrames = false;
+		}
+		m_depth--;
+		return ret;
+	}
+
+	bool start_array(std::size_t len) override
+	{
+		m_depth++;
+		return !m_dom || m_dom->start_array(len);
+	}
+
+	bool end_array() override
+	{
+		m_depth--;
+		return !m_dom || m_dom->end_array();
+	}
+
+	bool key(string_t& val) override
+	{
+		if (m_depth == 1)
+			m_isInFrames = (val == "frame_ID");
+		else if (m_depth == 2 && m_isInFrames)
+			m_frameIdx = std::atoi(val.c_str());
+		return !m_dom || m_dom->key(val);
+	}
+
+	bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+	{
+		std::cerr << "Parse error at byte " << position << ": " << ex.what() << "\n";
+		return false;
+	}
+
+private:
+	JSON_LOG_Filter& m_filter;
+	std::unique_ptr<nlohmann::detail::json_sax_dom_parser<json>> m_dom;
+	json m_frame;
+	int m_depth = 0;
+	int m_frameIdx = -1;
+	bool m_isInFrames = false;
+};
+
+// ============================================
+//                    Query
+// ============================================
+bool JSON_LOG_FilterQuery::Parse(const std::string& text)
+{
+	static const struct { const char* token; int op; } ops[] =
+	{
+		{"==", JSON_LOG_FILTER_EQ}, {"!=", JSON_LOG_FILTER_NE},
+		{"<=", JSON_LOG_FILTER_LE}, {">=", JSON_LOG_FILTER_GE},
+		{"<",  JSON_LOG_FILTER_LT}, {">",  JSON_LOG_FILTER_GT},
+	};
+
+	for (const auto& candidate : ops)
+	{
+		size_t pos = text.find(candidate.token);
+		if (pos == std::string::npos)
+			continue;
+
+		std::string path = text.substr(0, pos);
+		std::string valueText = text.substr(pos + strlen(candidate.token));
+		size_t dot = path.find('.');
+		if (dot == std::string::npos || dot == 0 || dot + 1 == path.size() || valueText.empty())
+			return false;
+
+		section = path.substr(0, dot);
+		field = path.substr(dot + 1);
+		op = candidate.op;
+
+		// Numbers and true/false/null as JSON, anything else as a plain string
+		value = json::parse(valueText, nullptr, false);
+		if (value.is_discarded() || value.is_structured())
+			value = valueText;
+		return true;
+	}
+	return false;
+}
+
+// ============================================
+//                    Filter
+// ============================================
+JSON_LOG_Filter::JSON_LOG_Filter(const JSON_LOG_FilterQuery& query)
+	: m_query(query)
+{
+}
+
+bool JSON_LOG_Filter::Run(const std::string& logFile, std::ostream& out)
+{
+	JSON_LOG_Reader reader;
+	if (!reader.Open(logFile))
+		return false;
+
+	m_out = &out;
+	m_numFrames = 0;
+	m_numMatches = 0;
+
+	if (reader.GetLayout() == JSON_LOG_READER_DOCUMENT)
+	{
+		// Legacy document: one SAX pass over the whole mapping
+		std::string_view data = reader.GetData();
+		FrameFilterSax sax(*this);
+		if (!json::sax_parse(data.begin(), data.end(), &sax, nlohmann::detail::input_format_t::json, false))
+			std::cerr << "Stopped at unreadable data after " << m_numFrames << " frames\n";
+	}
+	else
+	{
+		// One SAX pass per record
+		JSON_LOG_FrameView frame;
+		while (reader.NextFrame(frame))
+		{
+			FrameFilterSax sax(*this);
+			const char* begin = frame.data.data();
+			const char* end = begin + frame.data.size();
+			bool ok = true;
+
+			if (frame.format == JSON_LOG_FORMAT_CBOR)
+				ok = json::sax_parse(begin, end, &sax, nlohmann::detail::input_format_t::cbor, false);
+			else if (frame.format == JSON_LOG_FORMAT_MSGPACK)
+				ok = json::sax_parse(begin, end, &sax, nlohmann::detail::input_format_t::msgpack, false);
+			else
+				ok = json::sax_parse(begin, end, &sax, nlohmann::detail::input_format_t::json, false);
+
+			if (!ok)
+				std::cerr << "Skipping unreadable record of frame " << frame.frameIdx << "\n";
+		}
+
+		if (reader.IsTruncated())
+			std::cerr << "Truncated record at the end of " << logFile << "\n";
+	}
+
+	m_out = nullptr;
+	return true;
+}
+
+void JSON_LOG_Filter::OnFrame(int frameIdx, const json& frame)
+{
+	m_numFrames++;
+
+	auto section = frame.find(m_query.section);
+	if (section == frame.end())
+		return;
+
+	if (!m_query.emitFrames)
+	{
+		m_numMatches += _matchEntries(frameIdx, *section, m_query.section);
+		return;
+	}
+
+	// Frame mode: count the matches without writing them
+	std::ostream* out = m_out;
+	m_out = nullptr;
+	int numMatches = _matchEntries(frameIdx, *section, m_query.section);
+	m_out = out;
+
+	if (numMatches == 0)
+		return;
+
+	m_numMatches++;
+	if (m_out != nullptr)
+	{
+		json record;
+		record["frame_ID"][std::to_string(frameIdx)] = frame;
+		*m_out << record.dump() << "\n";
+	}
+}
+
+int JSON_LOG_Filter::_matchEntries(int frameIdx, const json& node, const std::string& group)
+{
+	int numMatches = 0;
+
+	if (node.is_array())
+	{
+		for (const auto& item : node)
+			numMatches += _matchEntries(frameIdx, item, group);
+		return numMatches;
+	}
+
+	if (!node.is_object())
+		return 0;
+
+	for (auto it = node.begin(); it != node.end(); ++it)
+	{
+		const std::string& key = it.key();
+		bool isField = (key == m_query.field) ||
+					   (key.size() > m_query.field.size() &&
+						key.compare(key.size() - m_query.field.size(), std::string::npos, m_query.field) == 0 &&
+						key[key.size() - m_query.field.size() - 1] == '.');
+
+		if (isField && it->is_primitive())
+		{
+			if (!_matchValue(*it))
+				continue;
+
+			if (m_out != nullptr)
+			{
+				json record;
+				record["frame_ID"] = frameIdx;
+				record["section"] = m_query.section;
+				record["group"] = group;
+				record["entry"] = node;
+				*m_out << record.dump() << "\n";
+			}
+			return 1;  // The entry matches once, whatever else it holds
+		}
+	}
+
+	for (auto it = node.begin(); it != node.end(); ++it)
+	{
+		if (it->is_structured())
+			numMatches += _matchEntries(frameIdx, *it, it.key());
+	}
+	return numMatches;
+}
+
+bool JSON_LOG_Filter::_matchValue(const json& value) const
+{
+	const json& target = m_query.value;
+
+	int cmp = 0;
+	if (value.is_number() && target.is_number())
+	{
+		double a = value.get<double>();
+		double b = target.get<double>();
+		cmp = (a < b) ? -1 : (a > b) ? 1 : 0;
+	}
+	else if (value.is_boolean() && target.is_number())
+	{
+		// FCW/LDW style flags may be queried as 0/1
+		double a = value.get<bool>() ? 1.0 : 0.0;
+		double b = target.get<double>();
+		cmp = (a < b) ? -1 : (a > b) ? 1 : 0;
+	}
+	else if (value.type() == target.type())
+	{
+		cmp = (value < target) ? -1 : (target < value) ? 1 : 0;
+	}
+	else
+	{
+		return m_query.op == JSON_LOG_FILTER_NE;
+	}
+
+	switch (m_query.op)
+	{
+		case JSON_LOG_FILTER_EQ: return cmp == 0;
+		case JSON_LOG_FILTER_NE: return cmp != 0;
+		case JSON_LOG_FILTER_LT: return cmp < 0;
+		case JSON_LOG_FILTER_LE: return cmp <= 0;
+		case JSON_LOG_FILTER_GT: return cmp > 0;
+		case JSON_LOG_FILTER_GE: return cmp >= 0;
+	}
+	return false;
+}
@@ -0,0 +1,77 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __JSON_LOG_FILTER__
+#define __JSON_LOG_FILTER__
+
+#include <ostream>
+#include <string>
+
+#include "json.hpp"
+
+enum JSON_LOG_FILTER_OP
+{
+	JSON_LOG_FILTER_EQ = 0,
+	JSON_LOG_FILTER_NE,
+	JSON_LOG_FILTER_LT,
+	JSON_LOG_FILTER_LE,
+	JSON_LOG_FILTER_GT,
+	JSON_LOG_FILTER_GE,
+};
+
+// <section>.<field> <op> <value>, e.g. "ADAS.FCW==1" or "trackObj.distanceToCamera<10".
+// An entry is any object inside the section of a frame that holds the field,
+// either as "field" or as "<prefix>.field" ("trackObj.distanceToCamera").
+struct JSON_LOG_FilterQuery
+{
+	std::string section;
+	std::string field;
+	int op = JSON_LOG_FILTER_EQ;
+	nlohmann::json value;
+
+	bool emitFrames = false;  // Emit whole matching frames instead of the matching entries
+
+	bool Parse(const std::string& text);
+};
+
+// Streams a log through the SAX interface and writes the matches as JSON Lines.
+//
+// Only the frame currently being parsed is kept as a DOM, so memory is bounded
+// by one frame whatever the size of the log. Entry matches are written as
+// {"frame_ID": N, "section": ..., "group": ..., "entry": {...}}, frame matches
+// as {"frame_ID": {"N": {...}}}.
+class JSON_LOG_Filter
+{
+public:
+	explicit JSON_LOG_Filter(const JSON_LOG_FilterQuery& query);
+
+	// Any layout understood by JSON_LOG_Reader
+	bool Run(const std::string& logFile, std::ostream& out);
+
+	int GetNumFrames() const { return m_numFrames; }
+	int GetNumMatches() const { return m_numMatches; }
+
+	// Called by the SAX handler for every completed frame
+	void OnFrame(int frameIdx, const nlohmann::json& frame);
+
+private:
+	bool _matchValue(const nlohmann::json& value) const;
+	int _matchEntries(int frameIdx, const nlohmann::json& node, const std::string& group);
+
+	JSON_LOG_FilterQuery m_query;
+	std::ostream* m_out = nullptr;
+	int m_numFrames = 0;
+	int m_numMatches = 0;
+};
+
+#endif
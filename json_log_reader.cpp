@@ -0,0 +1,419 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+#include "json_log_reader.hpp"
+#include "json_log.hpp"
+
+using json = nlohmann::json;
+
+// ============================================
+//               Scanner Helpers
+// ============================================
+static size_t skipSpace(const char* data, size_t size, size_t pos)
+{
+	while (pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r'))
+		pos++;
+	return pos;
+}
+
+// pos is at the opening quote, returns the position after the closing quote
+// or npos for an unterminated string
+static size_t skipString(const char* data, size_t size, size_t pos)
+{
+	for (pos++; pos < size; pos++)
+	{
+		if (data[pos] == '\\')
+			pos++;
+		else if (data[pos] == '"')
+			return pos + 1;
+	}
+	return std::string::npos;
+}
+
+// Returns the position after the JSON value starting at pos, npos when the
+// value is cut off by the end of the data
+static size_t skipValue(const char* data, size_t size, size_t pos)
+{
+	if (pos >= size)
+		return std::string::npos;
+
+	if (data[pos] == '"')
+		return skipString(data, size, pos);
+
+	if (data[pos] != '{' && data[pos] != '[')
+	{
+		while (pos < size && data[pos] != ',' && data[pos] != '}' && data[pos] != ']')
+			pos++;
+		return pos;
+	}
+
+	int depth = 0;
+	while (pos < size)
+	{
+		const char c = data[pos];
+		if (c == '"')
+		{
+			pos = skipString(data, size, pos);
+			if (pos == std::string::npos)
+				break;
+			continue;
+		}
+		if (c == '{' || c == '[')
+			depth++;
+		else if ((c == '}' || c == ']') && --depth == 0)
+			return pos + 1;
+		pos++;
+	}
+	return std::string::npos;
+}
+
+// Stops at the second key of {"frame_ID": {"N": ...}} without reading the frame
+class FrameIndexSax : public nlohmann::json_sax<json>
+{
+public:
+	int frameIdx = -1;
+
+	bool key(string_t& val) override
+	{
+		if (++m_numKeys < 2)
+			return true;
+		frameIdx = std::atoi(val.c_str());
+		return false;
+	}
+
+	bool null() override { return true; }
+	bool boolean(bool) override { return true; }
+	bool number_integer(number_integer_t) override { return true; }
+	bool number_unsigned(number_unsigned_t) override { return true; }
+	bool number_float(number_float_t, const string_t&) override { return true; }
+	bool string(string_t&) override { return true; }
+	bool binary(binary_t&) override { return true; }
+	bool start_object(std::size_t) override { return true; }
+	bool end_object() override { return true; }
+	bool start_array(std::size_t) override { return true; }
+	bool end_array() override { return true; }
+	bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override { return false; }
+
+private:
+	int m_numKeys = 0;
+};
+
+// ============================================
+//                  Constructor
+// ============================================
+JSON_LOG_Reader::JSON_LOG_Reader()
+{
+}
+
+JSON_LOG_Reader::~JSON_LOG_Reader()
+{
+	Close();
+}
+
+// ============================================
+//                 Open / Close
+// ============================================
+bool JSON_LOG_Reader::Open(const std::string& file)
+{
+	Close();
+
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "Unable to open the file: " << file << "\n";
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		std::cerr << "Empty or unreadable log file: " << file << "\n";
+		return false;
+	}
+
+	void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);  // Mapping keeps the file referenced
+	if (addr == MAP_FAILED)
+	{
+		std::cerr << "Unable to map the file: " << file << "\n";
+		return false;
+	}
+	madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	m_data = (const char*)addr;
+	m_size = (size_t)st.st_size;
+	m_begin = 0;
+	m_format = JSON_LOG_FORMAT_JSON;
+
+	if (m_size >= JSON_LOG_BINARY_HEADER_SIZE && memcmp(m_data, JSON_LOG_BINARY_MAGIC, 4) == 0)
+	{
+		m_layout = JSON_LOG_READER_BINARY;
+		m_format = (unsigned char)m_data[5];
+		m_begin = JSON_LOG_BINARY_HEADER_SIZE;
+
+		if (m_data[4] != JSON_LOG_BINARY_VERSION ||
+			(m_format != JSON_LOG_FORMAT_CBOR && m_format != JSON_LOG_FORMAT_MSGPACK))
+		{
+			std::cerr << "Unsupported binary JSON log version/format: "
+					  << (int)m_data[4] << "/" << m_format << "\n";
+			Close();
+			return false;
+		}
+	}
+	else
+	{
+		// A JSON Lines record has no newline before its end, a document written
+		// with dump(4) has one right after the opening brace
+		size_t pos = skipSpace(m_data, m_size, 0);
+		const char* newline = (const char*)memchr(m_data + pos, '\n', m_size - pos);
+		const size_t end = (newline != nullptr) ? (size_t)(newline - m_data) : m_size;
+		m_layout = (skipValue(m_data, m_size, pos) <= end) ? JSON_LOG_READER_LINES : JSON_LOG_READER_DOCUMENT;
+
+		if (m_layout == JSON_LOG_READER_DOCUMENT && !_findDocumentFrames())
+		{
+			std::cerr << "No frame_ID object in: " << file << "\n";
+			Close();
+			return false;
+		}
+	}
+
+	Rewind();
+	return true;
+}
+
+void JSON_LOG_Reader::Close()
+{
+	if (m_data != nullptr)
+		munmap((void*)m_data, m_size);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_cursor = 0;
+	m_begin = 0;
+	m_isTruncated = false;
+}
+
+void JSON_LOG_Reader::Rewind()
+{
+	m_cursor = m_begin;
+	m_isTruncated = false;
+}
+
+// ============================================
+//                Frame Iteration
+// ============================================
+bool JSON_LOG_Reader::NextFrame(JSON_LOG_FrameView& frame)
+{
+	if (m_data == nullptr)
+		return false;
+
+	frame.format = m_format;
+
+	if (m_layout == JSON_LOG_READER_BINARY)
+		return _nextBinary(frame);
+	else if (m_layout == JSON_LOG_READER_LINES)
+		return _nextLine(frame);
+	return _nextDocumentFrame(frame);
+}
+
+bool JSON_LOG_Reader::_nextLine(JSON_LOG_FrameView& frame)
+{
+	m_cursor = skipSpace(m_data, m_size, m_cursor);
+	if (m_cursor >= m_size)
+		return false;
+
+	const char* begin = m_data + m_cursor;
+	const char* newline = (const char*)memchr(begin, '\n', m_size - m_cursor);
+	size_t end = (newline != nullptr) ? (size_t)(newline - m_data) : skipValue(m_data, m_size, m_cursor);
+	if (end == std::string::npos)
+	{
+		// Writer stopped in the middle of the last record
+		m_isTruncated = true;
+		m_cursor = m_size;
+		return false;
+	}
+
+	frame.data = std::string_view(begin, end - m_cursor);
+	frame.isWrapped = true;
+	frame.frameIdx = _peekFrameIndex(frame);
+	m_cursor = end + 1;
+	return true;
+}
+
+bool JSON_LOG_Reader::_nextBinary(JSON_LOG_FrameView& frame)
+{
+	if (m_cursor >= m_size)
+		return false;
+
+	if (m_size - m_cursor < 4)
+	{
+		m_isTruncated = true;
+		return false;
+	}
+
+	const unsigned char* prefix = (const unsigned char*)m_data + m_cursor;
+	const size_t length = (size_t)prefix[0] | ((size_t)prefix[1] << 8) |
+						  ((size_t)prefix[2] << 16) | ((size_t)prefix[3] << 24);
+
+	if (m_size - m_cursor - 4 < length)
+	{
+		m_isTruncated = true;
+		return false;
+	}
+
+	frame.data = std::string_view(m_data + m_cursor + 4, length);
+	frame.isWrapped = true;
+	frame.frameIdx = _peekFrameIndex(frame);
+	m_cursor += 4 + length;
+	return true;
+}
+
+bool JSON_LOG_Reader::_findDocumentFrames()
+{
+	// Position m_begin right after the opening brace of "frame_ID": {
+	static const char key[] = "\"frame_ID\"";
+	size_t pos = skipSpace(m_data, m_size, 0);
+	if (pos >= m_size || m_data[pos] != '{')
+		return false;
+
+	pos = skipSpace(m_data, m_size, pos + 1);
+	while (pos < m_size && m_data[pos] == '"')
+	{
+		const size_t keyEnd = skipString(m_data, m_size, pos);
+		if (keyEnd == std::string::npos)
+			return false;
+		const bool isFrameKey = (keyEnd - pos == sizeof(key) - 1) && memcmp(m_data + pos, key, sizeof(key) - 1) == 0;
+
+		pos = skipSpace(m_data, m_size, keyEnd);
+		if (pos >= m_size || m_data[pos] != ':')
+			return false;
+		pos = skipSpace(m_data, m_size, pos + 1);
+
+		if (isFrameKey)
+		{
+			if (pos >= m_size || m_data[pos] != '{')
+				return false;
+			m_begin = pos + 1;
+			return true;
+		}
+
+		pos = skipSpace(m_data, m_size, skipValue(m_data, m_size, pos));
+		if (pos < m_size && m_data[pos] == ',')
+			pos = skipSpace(m_data, m_size, pos + 1);
+	}
+	return false;
+}
+
+bool JSON_LOG_Reader::_nextDocumentFrame(JSON_LOG_FrameView& frame)
+{
+	size_t pos = skipSpace(m_data, m_size, m_cursor);
+	if (pos < m_size && m_data[pos] == ',')
+		pos = skipSpace(m_data, m_size, pos + 1);
+
+	if (pos >= m_size || m_data[pos] != '"')
+	{
+		// '}' closes frame_ID, anything else is a cut off document
+		m_isTruncated = (pos >= m_size || m_data[pos] != '}');
+		m_cursor = m_size;
+		return false;
+	}
+
+	const size_t keyEnd = skipString(m_data, m_size, pos);
+	if (keyEnd == std::string::npos)
+	{
+		m_isTruncated = true;
+		m_cursor = m_size;
+		return false;
+	}
+	frame.frameIdx = std::atoi(std::string(m_data + pos + 1, keyEnd - pos - 2).c_str());
+
+	pos = skipSpace(m_data, m_size, keyEnd);
+	if (pos >= m_size || m_data[pos] != ':')
+	{
+		m_isTruncated = true;
+		m_cursor = m_size;
+		return false;
+	}
+
+	const size_t valueBegin = skipSpace(m_data, m_size, pos + 1);
+	const size_t valueEnd = skipValue(m_data, m_size, valueBegin);
+	if (valueEnd == std::string::npos)
+	{
+		m_isTruncated = true;
+		m_cursor = m_size;
+		return false;
+	}
+
+	frame.data = std::string_view(m_data + valueBegin, valueEnd - valueBegin);
+	frame.isWrapped = false;
+	m_cursor = valueEnd;
+	return true;
+}
+
+// ============================================
+//                Frame Parsing
+// ============================================
+int JSON_LOG_Reader::_peekFrameIndex(const JSON_LOG_FrameView& frame)
+{
+	FrameIndexSax sax;
+	const char* begin = frame.data.data();
+	const char* end = begin + frame.data.size();
+
+	if (frame.format == JSON_LOG_FORMAT_CBOR)
+		json::sax_parse(begin, end, &sax, nlohmann::detail::input_format_t::cbor, false);
+	else if (frame.format == JSON_LOG_FORMAT_MSGPACK)
+		json::sax_parse(begin, end, &sax, nlohmann::detail::input_format_t::msgpack, false);
+	else
+		json::sax_parse(begin, end, &sax, nlohmann::detail::input_format_t::json, false);
+
+	return sax.frameIdx;
+}
+
+bool JSON_LOG_Reader::ParseFrame(const JSON_LOG_FrameView& frame, json& frameJson)
+{
+	const char* begin = frame.data.data();
+	const char* end = begin + frame.data.size();
+	json record;
+
+	// Parsed straight from the mapping through nlohmann's iterator input adapter
+	if (frame.format == JSON_LOG_FORMAT_CBOR)
+		record = json::from_cbor(begin, end, true, false);
+	else if (frame.format == JSON_LOG_FORMAT_MSGPACK)
+		record = json::from_msgpack(begin, end, true, false);
+	else
+		record = json::parse(begin, end, nullptr, false);
+
+	if (record.is_discarded())
+		return false;
+
+	if (!frame.isWrapped)
+	{
+		frameJson = std::move(record);
+		return true;
+	}
+
+	auto frames = record.find("frame_ID");
+	if (frames == record.end() || !frames->is_object() || frames->empty())
+		return false;
+
+	frameJson = std::move(frames->begin().value());
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __JSON_LOG_READER__
+#define __JSON_LOG_READER__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "json.hpp"
+
+// Layout of the log file being read
+enum JSON_LOG_READER_LAYOUT
+{
+	JSON_LOG_READER_DOCUMENT = 0,  // Single {"frame_ID": {...}} document (SaveJsonLogFile)
+	JSON_LOG_READER_LINES,         // JSON Lines, one {"frame_ID": {"N": {...}}} per line
+	JSON_LOG_READER_BINARY,        // "JLOG" header + length prefixed CBOR / MessagePack records
+};
+
+// One frame of a mapped log. The data points into the mapping and stays
+// valid until the reader is closed.
+struct JSON_LOG_FrameView
+{
+	int frameIdx = -1;
+	std::string_view data;
+	int format = 0;          // JSON_LOG_FORMAT of data
+	bool isWrapped = true;   // data is {"frame_ID": {"N": {...}}}, otherwise the {...} of frame N
+};
+
+// Memory-mapped reader for JSON_LOG files.
+//
+// The file is mapped read-only and walked record by record, nothing is
+// copied to the heap. A frame is only parsed when ParseFrame() is called,
+// directly from the mapped bytes.
+class JSON_LOG_Reader
+{
+public:
+	JSON_LOG_Reader();
+	~JSON_LOG_Reader();
+
+	JSON_LOG_Reader(const JSON_LOG_Reader&) = delete;
+	JSON_LOG_Reader& operator=(const JSON_LOG_Reader&) = delete;
+
+	bool Open(const std::string& file);
+	void Close();
+	bool IsOpen() const { return m_data != nullptr; }
+
+	// Returns false at the end of the log or at a malformed/truncated record
+	bool NextFrame(JSON_LOG_FrameView& frame);
+	void Rewind();
+
+	// Content of frame N, i.e. the value of frame_ID -> N
+	static bool ParseFrame(const JSON_LOG_FrameView& frame, nlohmann::json& frameJson);
+
+	int GetLayout() const { return m_layout; }
+	int GetFormat() const { return m_format; }
+	size_t GetSize() const { return m_size; }
+	std::string_view GetData() const { return std::string_view(m_data, m_size); }
+	bool IsTruncated() const { return m_isTruncated; }
+
+private:
+	bool _nextLine(JSON_LOG_FrameView& frame);
+	bool _nextBinary(JSON_LOG_FrameView& frame);
+	bool _nextDocumentFrame(JSON_LOG_FrameView& frame);
+	bool _findDocumentFrames();
+
+	static int _peekFrameIndex(const JSON_LOG_FrameView& frame);
+
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_cursor = 0;
+	size_t m_begin = 0;           // First record
+	int m_layout = JSON_LOG_READER_LINES;
+	int m_format = 0;
+	bool m_isTruncated = false;
+};
+
+#endif
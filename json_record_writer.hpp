@@ -0,0 +1,92 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __JSON_RECORD_WRITER__
+#define __JSON_RECORD_WRITER__
+
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+#include "json.hpp"
+
+// Appends compact JSON text to a caller-owned std::string.
+//
+// Numbers are formatted exactly like nlohmann::json::dump(): integers with
+// std::to_chars, floating point values as double with the vendored Grisu2
+// to_chars (shortest round-trip) and NaN/Inf as null. Keys and structural
+// tokens are string literals whose length is known at compile time.
+class JsonRecordWriter
+{
+public:
+	explicit JsonRecordWriter(std::string& buffer) : m_buffer(buffer) {}
+
+	// Structural text or a pre-quoted key, e.g. raw("\"x1\":")
+	template <size_t N>
+	void raw(const char (&text)[N])
+	{
+		m_buffer.append(text, N - 1);
+	}
+
+	void raw(char c)
+	{
+		m_buffer.push_back(c);
+	}
+
+	// Quoted string without escaping (labels are plain ASCII)
+	void string(const char* text)
+	{
+		m_buffer.push_back('"');
+		m_buffer.append(text);
+		m_buffer.push_back('"');
+	}
+
+	void number(bool value)
+	{
+		if (value)
+			raw("true");
+		else
+			raw("false");
+	}
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+	number(T value)
+	{
+		char buf[24];
+		std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), value);
+		m_buffer.append(buf, res.ptr - buf);
+	}
+
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value>::type
+	number(T value)
+	{
+		const double x = static_cast<double>(value);
+		if (!std::isfinite(x))
+		{
+			raw("null");
+			return;
+		}
+
+		char buf[64];
+		char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), x);
+		m_buffer.append(buf, end - buf);
+	}
+
+private:
+	std::string& m_buffer;
+};
+
+#endif
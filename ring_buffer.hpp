@@ -0,0 +1,127 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __RING_BUFFER__
+#define __RING_BUFFER__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free ring buffer (one producer thread).
+//
+// Every slot carries a sequence number, so a pop may also be issued by the
+// producer thread itself, e.g. to discard the oldest item when the buffer is
+// full. Items are swapped with the slot contents instead of being copied:
+// containers inside T keep their capacity and circulate between producer and
+// consumer without reallocation.
+template <typename T>
+class RingBuffer
+{
+public:
+	explicit RingBuffer(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+
+		m_mask = size - 1;
+		m_cells.reset(new Cell[size]);
+		for (size_t i = 0; i < size; i++)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	// Producer only. Returns false when the buffer is full.
+	bool tryPush(T& item)
+	{
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		Cell& cell = m_cells[pos & m_mask];
+
+		if (cell.sequence.load(std::memory_order_acquire) != pos)
+			return false;
+
+		std::swap(cell.data, item);
+		cell.sequence.store(pos + 1, std::memory_order_release);
+		m_tail.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer (or producer dropping the oldest item). Returns false when empty.
+	bool tryPop(T& item)
+	{
+		size_t pos = m_head.load(std::memory_order_relaxed);
+		Cell* cell = nullptr;
+
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = m_head.load(std::memory_order_relaxed);
+			}
+		}
+
+		std::swap(item, cell->data);
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t size() const
+	{
+		size_t tail = m_tail.load(std::memory_order_acquire);
+		size_t head = m_head.load(std::memory_order_acquire);
+		return tail > head ? tail - head : 0;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	size_t capacity() const
+	{
+		return m_mask + 1;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	std::unique_ptr<Cell[]> m_cells;
+	size_t m_mask = 0;
+
+	alignas(64) std::atomic<size_t> m_head{0};
+	alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+#endif
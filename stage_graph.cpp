@@ -0,0 +1,84 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include "stage_graph.hpp"
+
+StageGraph::StageGraph(WorkerPool* pool)
+	: m_pool(pool)
+{
+}
+
+int StageGraph::addStage(const std::string& name, std::function<bool()> func,
+						 const std::vector<int>& dependencies)
+{
+	int stageIdx = (int)m_stages.size();
+
+	m_stages.emplace_back();
+	Stage& stage = m_stages.back();
+	stage.name = name;
+	stage.func = std::move(func);
+
+	for (int i = 0; i < dependencies.size(); i++)
+	{
+		int dependency = dependencies[i];
+		if (dependency < 0 || dependency >= stageIdx)
+			continue;  // Only earlier stages, keeps the graph acyclic
+
+		m_stages[dependency].dependents.push_back(stageIdx);
+		stage.numDependencies++;
+	}
+
+	return stageIdx;
+}
+
+bool StageGraph::run()
+{
+	const int numStages = (int)m_stages.size();
+
+	m_numDone = 0;
+	m_isSuccess = true;
+	for (int i = 0; i < numStages; i++)
+	{
+		m_stages[i].numPending = m_stages[i].numDependencies;
+		m_stages[i].result = true;
+	}
+
+	for (int i = 0; i < numStages; i++)
+	{
+		if (m_stages[i].numDependencies == 0)
+			m_pool->submit([this, i] { _runStage(i); });
+	}
+
+	m_pool->waitUntil([this, numStages] { return m_numDone.load() == numStages; });
+
+	return m_isSuccess;
+}
+
+void StageGraph::_runStage(int stageIdx)
+{
+	Stage& stage = m_stages[stageIdx];
+
+	stage.result = stage.func();
+	if (!stage.result)
+		m_isSuccess = false;
+
+	// Queue the dependents this stage was the last dependency of
+	for (int i = 0; i < stage.dependents.size(); i++)
+	{
+		int dependent = stage.dependents[i];
+		if (--m_stages[dependent].numPending == 0)
+			m_pool->submit([this, dependent] { _runStage(dependent); });
+	}
+
+	m_numDone++;
+}
@@ -0,0 +1,75 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __STAGE_GRAPH__
+#define __STAGE_GRAPH__
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "worker_pool.hpp"
+
+// Per-frame processing stages with explicit dependencies.
+//
+// run() starts every stage without dependencies, and a stage is queued on the
+// worker pool as soon as the last stage it depends on is done, so independent
+// branches run concurrently. Stages that run at the same time must not write
+// state the other one reads.
+//
+// Dependencies must be added before their dependents, and ready stages are
+// queued in the order they were added: with a pool of 0 threads run() is the
+// plain serial sequence on the calling thread.
+class StageGraph
+{
+public:
+	explicit StageGraph(WorkerPool* pool);
+
+	// Returns the stage id. func returns false on failure; the remaining
+	// stages still run, like the serial code.
+	int addStage(const std::string& name, std::function<bool()> func,
+				 const std::vector<int>& dependencies = std::vector<int>());
+
+	// One frame, returns false if any stage failed
+	bool run();
+
+	int getNumStages() const { return (int)m_stages.size(); }
+	const std::string& getStageName(int stageIdx) const { return m_stages[stageIdx].name; }
+	bool getStageResult(int stageIdx) const { return m_stages[stageIdx].result; }
+
+private:
+	struct Stage
+	{
+		std::string name;
+		std::function<bool()> func;
+		std::vector<int> dependents;
+		int numDependencies = 0;
+		std::atomic<int> numPending{0};
+		bool result = true;
+
+		Stage() {}
+		Stage(const Stage& other)
+			: name(other.name), func(other.func), dependents(other.dependents),
+			  numDependencies(other.numDependencies), result(other.result) {}
+	};
+
+	void _runStage(int stageIdx);
+
+	WorkerPool* m_pool;
+	std::vector<Stage> m_stages;
+	std::atomic<int> m_numDone{0};
+	std::atomic<bool> m_isSuccess{true};
+};
+
+#endif
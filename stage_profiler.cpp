@@ -0,0 +1,240 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "stage_profiler.hpp"
+
+StageProfiler::StageProfiler(const std::vector<std::string>& stageNames, size_t traceSize)
+	: m_stageNames(stageNames),
+	  m_histograms(stageNames.size()),
+	  m_traceEvents(traceSize)
+{
+	reset();
+}
+
+void StageProfiler::reset()
+{
+	for (int i = 0; i < m_histograms.size(); i++)
+	{
+		Histogram& hist = m_histograms[i];
+		for (int j = 0; j < STAGE_PROFILER_NUM_BUCKETS; j++)
+			hist.buckets[j].store(0, std::memory_order_relaxed);
+		hist.count.store(0, std::memory_order_relaxed);
+		hist.sumNs.store(0, std::memory_order_relaxed);
+		hist.maxNs.store(0, std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < m_traceEvents.size(); i++)
+		m_traceEvents[i].seq.store(0, std::memory_order_relaxed);
+
+	m_numTraceEvents.store(0, std::memory_order_relaxed);
+	m_startTime = Clock::now();
+}
+
+void StageProfiler::record(int stageIdx, Clock::time_point start, Clock::time_point end)
+{
+	if (stageIdx < 0 || stageIdx >= m_histograms.size())
+		return;
+
+	int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	if (durationNs < 0)
+		durationNs = 0;
+
+	// Histogram
+	Histogram& hist = m_histograms[stageIdx];
+	hist.buckets[_getBucketIdx(durationNs)].fetch_add(1, std::memory_order_relaxed);
+	hist.count.fetch_add(1, std::memory_order_relaxed);
+	hist.sumNs.fetch_add(durationNs, std::memory_order_relaxed);
+
+	uint64_t maxNs = hist.maxNs.load(std::memory_order_relaxed);
+	while (durationNs > maxNs
+		   && !hist.maxNs.compare_exchange_weak(maxNs, durationNs, std::memory_order_relaxed))
+	{
+	}
+
+	// Trace event
+	if (m_traceEvents.empty())
+		return;
+
+	uint64_t eventIdx = m_numTraceEvents.fetch_add(1, std::memory_order_relaxed);
+	TraceEvent& event = m_traceEvents[eventIdx % m_traceEvents.size()];
+
+	event.seq.store(eventIdx * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.stageIdx.store(stageIdx, std::memory_order_relaxed);
+	event.threadIdx.store(_getThreadIdx(), std::memory_order_relaxed);
+	event.startNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_startTime).count(),
+						std::memory_order_relaxed);
+	event.durationNs.store(durationNs, std::memory_order_relaxed);
+
+	event.seq.store(eventIdx * 2 + 2, std::memory_order_release);
+}
+
+uint64_t StageProfiler::getCount(int stageIdx) const
+{
+	return m_histograms[stageIdx].count.load(std::memory_order_relaxed);
+}
+
+double StageProfiler::getMeanMs(int stageIdx) const
+{
+	const Histogram& hist = m_histograms[stageIdx];
+
+	uint64_t count = hist.count.load(std::memory_order_relaxed);
+	if (count == 0)
+		return 0;
+
+	return hist.sumNs.load(std::memory_order_relaxed) / (double)count / 1e6;
+}
+
+double StageProfiler::getMaxMs(int stageIdx) const
+{
+	return m_histograms[stageIdx].maxNs.load(std::memory_order_relaxed) / 1e6;
+}
+
+double StageProfiler::getPercentileMs(int stageIdx, double percentile) const
+{
+	const Histogram& hist = m_histograms[stageIdx];
+
+	uint64_t count = 0;
+	for (int i = 0; i < STAGE_PROFILER_NUM_BUCKETS; i++)
+		count += hist.buckets[i].load(std::memory_order_relaxed);
+	if (count == 0)
+		return 0;
+
+	uint64_t rank = (uint64_t)std::ceil(percentile / 100.0 * count);
+	if (rank < 1)
+		rank = 1;
+	if (rank > count)
+		rank = count;
+
+	uint64_t numBelow = 0;
+	for (int i = 0; i < STAGE_PROFILER_NUM_BUCKETS; i++)
+	{
+		numBelow += hist.buckets[i].load(std::memory_order_relaxed);
+		if (numBelow >= rank)
+		{
+			// Bucket middle, never above the largest value recorded
+			uint64_t valueNs = _getBucketValue(i);
+			uint64_t maxNs = hist.maxNs.load(std::memory_order_relaxed);
+			if (valueNs > maxNs)
+				valueNs = maxNs;
+			return valueNs / 1e6;
+		}
+	}
+
+	return getMaxMs(stageIdx);
+}
+
+std::string StageProfiler::getSummary() const
+{
+	std::string summary;
+	char line[256];
+
+	for (int i = 0; i < getNumStages(); i++)
+	{
+		snprintf(line, sizeof(line),
+				 "%-20s count %8llu  mean %8.3f  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms\n",
+				 m_stageNames[i].c_str(), (unsigned long long)getCount(i), getMeanMs(i),
+				 getPercentileMs(i, 50), getPercentileMs(i, 95), getPercentileMs(i, 99), getMaxMs(i));
+		summary += line;
+	}
+
+	return summary;
+}
+
+bool StageProfiler::saveChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+		return false;
+
+	// Process name, then the complete ("X") events still in the buffer
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ADAS\"}}";
+
+	char line[256];
+	for (int i = 0; i < m_traceEvents.size(); i++)
+	{
+		const TraceEvent& event = m_traceEvents[i];
+
+		uint64_t seq = event.seq.load(std::memory_order_acquire);
+		if (seq == 0 || (seq & 1))
+			continue;
+
+		int stageIdx = event.stageIdx.load(std::memory_order_relaxed);
+		int threadIdx = event.threadIdx.load(std::memory_order_relaxed);
+		int64_t startNs = event.startNs.load(std::memory_order_relaxed);
+		int64_t durationNs = event.durationNs.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (event.seq.load(std::memory_order_relaxed) != seq)
+			continue;  // Overwritten while read
+		if (stageIdx < 0 || stageIdx >= getNumStages())
+			continue;
+
+		snprintf(line, sizeof(line),
+				 "{\"name\":\"%s\",\"cat\":\"adas\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+				 m_stageNames[stageIdx].c_str(), startNs / 1e3, durationNs / 1e3, threadIdx);
+
+		file << ",\n" << line;
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	return file.good();
+}
+
+int StageProfiler::_getBucketIdx(uint64_t valueNs)
+{
+	const uint64_t subBucketCount = 1 << STAGE_PROFILER_SUB_BUCKET_BITS;
+	const uint64_t maxValue = (2ULL << STAGE_PROFILER_MAX_BIT) - 1;
+
+	if (valueNs > maxValue)
+		valueNs = maxValue;
+	if (valueNs < subBucketCount)
+		return (int)valueNs;
+
+	// Highest bit selects the group, the next SUB_BUCKET_BITS bits the bucket
+	int msb = 63 - __builtin_clzll(valueNs);
+	int group = msb - STAGE_PROFILER_SUB_BUCKET_BITS + 1;
+	int subBucket = (int)((valueNs >> (msb - STAGE_PROFILER_SUB_BUCKET_BITS)) & (subBucketCount - 1));
+
+	return (group << STAGE_PROFILER_SUB_BUCKET_BITS) + subBucket;
+}
+
+uint64_t StageProfiler::_getBucketValue(int bucketIdx)
+{
+	const int subBucketCount = 1 << STAGE_PROFILER_SUB_BUCKET_BITS;
+
+	if (bucketIdx < subBucketCount)
+		return bucketIdx;
+
+	int group = bucketIdx >> STAGE_PROFILER_SUB_BUCKET_BITS;
+	uint64_t subBucket = (bucketIdx & (subBucketCount - 1)) | subBucketCount;
+	int shift = group - 1;
+
+	uint64_t lowest = subBucket << shift;
+	return lowest + ((1ULL << shift) >> 1);
+}
+
+// Small stable ids for the trace viewer instead of native thread handles
+int StageProfiler::_getThreadIdx()
+{
+	static std::atomic<int> numThreads{0};
+	thread_local int threadIdx = ++numThreads;
+	return threadIdx;
+}
@@ -0,0 +1,125 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __STAGE_PROFILER__
+#define __STAGE_PROFILER__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Trace events kept for saveChromeTrace(), the oldest are overwritten
+#define STAGE_PROFILER_DEFAULT_TRACE_SIZE 16384
+
+// Log-linear buckets: 16 per power of two (about 3% error) up to 2^41 ns
+#define STAGE_PROFILER_SUB_BUCKET_BITS 4
+#define STAGE_PROFILER_MAX_BIT 40
+#define STAGE_PROFILER_NUM_BUCKETS \
+	((STAGE_PROFILER_MAX_BIT - STAGE_PROFILER_SUB_BUCKET_BITS + 2) << STAGE_PROFILER_SUB_BUCKET_BITS)
+
+// Latency histograms and a timeline of trace events per processing stage.
+//
+// record() is lock free (relaxed atomic adds), so stages on the frame loop,
+// the stage workers and the render workers can all report at once. Reading
+// (percentiles, summary, trace export) may run at any time; it sees a
+// consistent-enough snapshot, not an atomic one.
+class StageProfiler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	explicit StageProfiler(const std::vector<std::string>& stageNames,
+						   size_t traceSize = STAGE_PROFILER_DEFAULT_TRACE_SIZE);
+
+	StageProfiler(const StageProfiler&) = delete;
+	StageProfiler& operator=(const StageProfiler&) = delete;
+
+	void record(int stageIdx, Clock::time_point start, Clock::time_point end);
+
+	// Clear histograms and trace events
+	void reset();
+
+	int getNumStages() const { return (int)m_stageNames.size(); }
+	const std::string& getStageName(int stageIdx) const { return m_stageNames[stageIdx]; }
+
+	uint64_t getCount(int stageIdx) const;
+	double getMeanMs(int stageIdx) const;
+	double getMaxMs(int stageIdx) const;
+	double getPercentileMs(int stageIdx, double percentile) const;  // percentile in [0, 100]
+
+	// One line per stage: count, mean, p50, p95, p99, max
+	std::string getSummary() const;
+
+	// Chrome trace-event JSON, open with chrome://tracing or Perfetto
+	bool saveChromeTrace(const std::string& path) const;
+
+private:
+	struct Histogram
+	{
+		std::atomic<uint32_t> buckets[STAGE_PROFILER_NUM_BUCKETS];
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> sumNs;
+		std::atomic<uint64_t> maxNs;
+	};
+
+	// Seqlock slot: seq is odd while written, 2 * (event index + 1) when done
+	struct TraceEvent
+	{
+		std::atomic<uint64_t> seq;
+		std::atomic<int> stageIdx;
+		std::atomic<int> threadIdx;
+		std::atomic<int64_t> startNs;
+		std::atomic<int64_t> durationNs;
+	};
+
+	static int _getBucketIdx(uint64_t valueNs);
+	static uint64_t _getBucketValue(int bucketIdx);
+	static int _getThreadIdx();
+
+	std::vector<std::string> m_stageNames;
+	std::vector<Histogram> m_histograms;
+	std::vector<TraceEvent> m_traceEvents;
+	std::atomic<uint64_t> m_numTraceEvents{0};
+	Clock::time_point m_startTime;
+};
+
+// Times the enclosing scope as one run of a stage. A null profiler is a no-op.
+class ScopedStageTimer
+{
+public:
+	ScopedStageTimer(StageProfiler* profiler, int stageIdx)
+		: m_profiler(profiler), m_stageIdx(stageIdx)
+	{
+		if (m_profiler != nullptr)
+			m_start = StageProfiler::Clock::now();
+	}
+
+	~ScopedStageTimer()
+	{
+		if (m_profiler != nullptr)
+			m_profiler->record(m_stageIdx, m_start, StageProfiler::Clock::now());
+	}
+
+	ScopedStageTimer(const ScopedStageTimer&) = delete;
+	ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+	StageProfiler* m_profiler;
+	int m_stageIdx;
+	StageProfiler::Clock::time_point m_start;
+};
+
+#endif
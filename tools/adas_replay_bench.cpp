@@ -0,0 +1,366 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+// Offline replay benchmark (QCS6490 build): feeds recorded frames through
+// ADAS::run at full speed with display off, then prints FPS, the latency of
+// every stage and the memory high-water marks.
+//
+// Usage: adas_replay_bench <config> <frame dir> [--log <frame log>] [--repeat <N>] [--trace <file>]
+//                          [--check-tracking]
+//   frame dir : frame_<N>.jpg images as saved by the raw image dump, replayed
+//               in frame order. The crop ratios of the config are applied, so
+//               use a full-frame crop for model-size images.
+//   --log     : headless mode, the detections of each frame come from a
+//               recorded frame log (any layout JSON_LOG_Reader opens) instead
+//               of YOLO-ADAS, the NPU is not fed. Lane masks are blank
+//               (model size), so the lane stages see no lines.
+//   --repeat  : replay the frames N times (default 1)
+//   --trace   : save the Chrome trace of the stages
+//   --check-tracking : with --log, replay through a serial and a parallel
+//               tracking ADAS side by side instead of timing, and report
+//               every frame whose results differ (exit code 1 if any)
+
+#include <cstdio>
+#include <dirent.h>
+#include <opencv2/imgcodecs.hpp>
+
+#include "adas.hpp"
+#include "bbox_rescale.hpp"
+#include "json_log_reader.hpp"
+
+// Recorded detections of one frame, model size, indexed by DETECT_CLASS
+struct ReplayFrame
+{
+	std::vector<BoundingBox> bboxLists[DETECT_NUM_CLASSES];
+};
+
+static bool listFrames(const std::string& dirPath, std::vector<std::pair<int, std::string>>& frames)
+{
+	DIR* dir = opendir(dirPath.c_str());
+	if (dir == nullptr)
+		return false;
+
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		int frameIdx = 0;
+		char ext[8] = {0};
+		if (sscanf(entry->d_name, "frame_%d.%7s", &frameIdx, ext) == 2)
+			frames.push_back(std::make_pair(frameIdx, dirPath + "/" + entry->d_name));
+	}
+	closedir(dir);
+
+	std::sort(frames.begin(), frames.end());
+	return true;
+}
+
+static bool loadReplayLog(const std::string& logPath, ADAS_Config_S* config,
+						  std::vector<ReplayFrame>& replayFrames)
+{
+	// Logged boxes are frame size, YOLO-ADAS results are model size
+	bboxUtil::RescaleRatio ratio = bboxUtil::getRescaleRatio(
+		config->frameWidth, config->frameHeight,
+		config->modelWidth, config->modelHeight);
+
+	// Same order as DETECT_CLASS, see the frame record labels of JSON_LOG
+	const char* detectLabels[DETECT_NUM_CLASSES] =
+	{
+		"HUMAN",
+		"SMALL_VEHICLE",
+		"VEHICLE",
+		"ROAD_SIGN",
+		"STOP_SIGN"
+	};
+
+	JSON_LOG_Reader reader;
+	if (!reader.Open(logPath))
+		return false;
+
+	JSON_LOG_FrameView frameView;
+	nlohmann::json frameJson;
+	while (reader.NextFrame(frameView))
+	{
+		if (!JSON_LOG_Reader::ParseFrame(frameView, frameJson))
+			continue;
+
+		replayFrames.emplace_back();
+		ReplayFrame& replayFrame = replayFrames.back();
+
+		if (!frameJson.contains("detectObj"))
+			continue;
+
+		const nlohmann::json& detectObj = frameJson["detectObj"];
+		for (int j = 0; j < DETECT_NUM_CLASSES; j++)
+		{
+			if (!detectObj.contains(detectLabels[j]))
+				continue;
+
+			const nlohmann::json& detectArray = detectObj[detectLabels[j]];
+			for (int i = 0; i < detectArray.size(); i++)
+			{
+				const nlohmann::json& det = detectArray[i];
+
+				BoundingBox box(det.value("detectObj.x1", 0), det.value("detectObj.y1", 0),
+								det.value("detectObj.x2", 0), det.value("detectObj.y2", 0), j);
+				box.confidence = det.value("detectObj.confidence", 0.0f);
+				bboxUtil::rescaleBBox(box, box, ratio);
+
+				replayFrame.bboxLists[j].push_back(box);
+			}
+		}
+	}
+
+	return true;
+}
+
+// Detections of the frame being replayed, read when ADAS asks for a result
+static std::function<bool(POST_PROC_RESULTS& result)> getReplaySource(
+	const std::vector<ReplayFrame>& replayFrames, ADAS_Config_S* config, const int& currFrameIdx)
+{
+	return [&replayFrames, config, &currFrameIdx](POST_PROC_RESULTS& result)
+	{
+		const ReplayFrame& replayFrame = replayFrames[currFrameIdx % replayFrames.size()];
+
+		// No lane lines without the segmentation head
+		result.laneMask = cv::Mat::zeros(config->modelHeight, config->modelWidth, CV_8UC1);
+		result.horiLineMask = cv::Mat::zeros(config->modelHeight, config->modelWidth, CV_8UC1);
+
+		result.humanBBoxList = replayFrame.bboxLists[DETECT_CLASS_HUMAN];
+		result.riderBBoxList = replayFrame.bboxLists[DETECT_CLASS_RIDER];
+		result.vehicleBBoxList = replayFrame.bboxLists[DETECT_CLASS_VEHICLE];
+		result.roadSignBBoxList = replayFrame.bboxLists[DETECT_CLASS_ROAD_SIGN];
+		result.stopSignBBoxList = replayFrame.bboxLists[DETECT_CLASS_STOP_SIGN];
+		return true;
+	};
+}
+
+static bool isSameTrackedObject(const Object& a, const Object& b)
+{
+	if (a.id != b.id
+		|| a.distanceToCamera != b.distanceToCamera
+		|| a.bboxList.size() != b.bboxList.size())
+		return false;
+
+	if (a.bboxList.empty())
+		return true;
+
+	const BoundingBox& boxA = a.bboxList.back();
+	const BoundingBox& boxB = b.bboxList.back();
+	return boxA.x1 == boxB.x1 && boxA.y1 == boxB.y1
+		&& boxA.x2 == boxB.x2 && boxA.y2 == boxB.y2
+		&& boxA.label == boxB.label;
+}
+
+// Serial and parallel tracking must give the same tracked objects, TTC based
+// following distance and events on every frame
+static int checkParallelTracking(const std::string& configPath, ADAS_Config_S* config,
+								 std::vector<cv::Mat>& frames,
+								 const std::vector<ReplayFrame>& replayFrames)
+{
+	ADAS serialADAS(configPath);
+	ADAS parallelADAS(configPath);
+	ADAS* adasList[] = {&serialADAS, &parallelADAS};
+
+	int currFrameIdx = 0;
+	for (int k = 0; k < 2; k++)
+	{
+		adasList[k]->m_dsp_results = false;
+		adasList[k]->m_dbg_saveImages = false;
+		adasList[k]->m_dbg_saveRawImages = false;
+		adasList[k]->setParallelTracking(k == 1);
+		adasList[k]->setReplaySource(getReplaySource(replayFrames, config, currFrameIdx));
+	}
+
+	cv::Mat resultMat;
+	ADAS_Results results[2];
+	std::vector<Object> objLists[2];
+	float followingDistances[2];
+	int numMismatches = 0;
+
+	for (int i = 0; i < frames.size(); i++)
+	{
+		currFrameIdx = i;
+		for (int k = 0; k < 2; k++)
+		{
+			adasList[k]->run(frames[i], resultMat);
+			adasList[k]->getResults(results[k]);
+			adasList[k]->getTrackedObjects(objLists[k]);
+			followingDistances[k] = adasList[k]->getFollowingDistance();
+		}
+
+		bool isSame = (results[0].eventType == results[1].eventType
+					   && followingDistances[0] == followingDistances[1]
+					   && objLists[0].size() == objLists[1].size());
+		for (int j = 0; isSame && j < objLists[0].size(); j++)
+			isSame = isSameTrackedObject(objLists[0][j], objLists[1][j]);
+
+		if (!isSame)
+		{
+			numMismatches++;
+			cerr << "Frame " << i << ": serial and parallel tracking differ ("
+				 << objLists[0].size() << " / " << objLists[1].size() << " objects, event "
+				 << results[0].eventType << " / " << results[1].eventType << ")" << endl;
+		}
+	}
+
+	cout << "Tracking check: " << frames.size() << " frames, " << numMismatches << " differ" << endl;
+	return numMismatches == 0 ? 0 : 1;
+}
+
+static long getPeakRssKB()
+{
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return atol(line.c_str() + 6);
+	}
+	return -1;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		cerr << "Usage: " << argv[0]
+			 << " <config> <frame dir> [--log <frame log>] [--repeat <N>] [--trace <file>] [--check-tracking]" << endl;
+		return 1;
+	}
+
+	std::string configPath = argv[1];
+	std::string frameDirPath = argv[2];
+	std::string logPath;
+	std::string tracePath;
+	int numRepeats = 1;
+	bool checkTracking = false;
+
+	for (int i = 3; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (option == "--check-tracking")
+		{
+			checkTracking = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			cerr << "Missing value of " << option << endl;
+			return 1;
+		}
+
+		if (option == "--log")
+			logPath = argv[++i];
+		else if (option == "--repeat")
+			numRepeats = std::max(1, atoi(argv[++i]));
+		else if (option == "--trace")
+			tracePath = argv[++i];
+		else
+		{
+			cerr << "Unknown option " << option << endl;
+			return 1;
+		}
+	}
+
+	// Decode every frame up front, the benchmark measures ADAS, not the disk
+	std::vector<std::pair<int, std::string>> framePaths;
+	if (!listFrames(frameDirPath, framePaths) || framePaths.empty())
+	{
+		cerr << "No frame_<N> images in " << frameDirPath << endl;
+		return 1;
+	}
+
+	std::vector<cv::Mat> frames;
+	for (int i = 0; i < framePaths.size(); i++)
+	{
+		cv::Mat frame = cv::imread(framePaths[i].second, cv::IMREAD_COLOR);
+		if (frame.empty())
+		{
+			cerr << "Read " << framePaths[i].second << " failed" << endl;
+			return 1;
+		}
+		frames.push_back(frame);
+	}
+	cout << "Loaded " << frames.size() << " frames" << endl;
+
+	ADAS_ConfigReader configReader;
+	configReader.read(configPath);
+	ADAS_Config_S* config = configReader.getConfig();
+
+	// Headless mode: recorded detections of the frame being replayed
+	std::vector<ReplayFrame> replayFrames;
+	if (!logPath.empty())
+	{
+		if (!loadReplayLog(logPath, config, replayFrames) || replayFrames.empty())
+		{
+			cerr << "Read frame log " << logPath << " failed" << endl;
+			return 1;
+		}
+		cout << "Loaded " << replayFrames.size() << " recorded frames" << endl;
+	}
+
+	if (checkTracking)
+	{
+		// Same detections for both, YOLO-ADAS timing would differ
+		if (replayFrames.empty())
+		{
+			cerr << "--check-tracking needs a recorded frame log (--log)" << endl;
+			return 1;
+		}
+		return checkParallelTracking(configPath, config, frames, replayFrames);
+	}
+
+	ADAS adas(configPath);
+	adas.m_dsp_results = false;
+	adas.m_dbg_saveImages = false;
+	adas.m_dbg_saveRawImages = false;
+
+	int currFrameIdx = 0;
+	if (!replayFrames.empty())
+		adas.setReplaySource(getReplaySource(replayFrames, config, currFrameIdx));
+
+	// Replay
+	cv::Mat resultMat;
+	int numFrames = 0;
+	int numFailures = 0;
+
+	auto time_0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < numRepeats; r++)
+	{
+		for (int i = 0; i < frames.size(); i++)
+		{
+			currFrameIdx = i;
+			if (!adas.run(frames[i], resultMat))
+				numFailures++;
+			numFrames++;
+		}
+	}
+	auto time_1 = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration_cast<std::chrono::microseconds>(time_1 - time_0).count() / 1e6;
+
+	cout << endl;
+	cout << "Frames: " << numFrames << " (" << numFailures << " failed)" << endl;
+	cout << "Time: " << seconds << " s" << endl;
+	cout << "FPS: " << (seconds > 0 ? numFrames / seconds : 0) << endl;
+	cout << "Peak RSS: " << getPeakRssKB() << " kB" << endl;
+
+	adas.showStageLatency();
+	adas.showMemoryUsage();
+
+	if (!tracePath.empty() && !adas.saveStageTrace(tracePath))
+		return 1;
+
+	return 0;
+}
@@ -0,0 +1,637 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+// Microbenchmarks of the JSON_LOG frame serialization, in the manner of
+// Google Benchmark: every case runs until --min-time has passed and reports
+// ns, heap allocations and bytes written per logged frame.
+//
+// Usage: json_log_bench [--filter <substring>] [--min-time <s>] [--dir <path>] [--max-log-mb <MB>]
+//   --filter     : run the cases whose name contains the substring
+//   --min-time   : seconds per case (default 0.5)
+//   --dir        : directory of the temporary log files (default /tmp)
+//   --max-log-mb : skip the cases whose prefilled log would be larger (default 1024)
+//
+// Case names are BM_<API>/objects:<N>/mode:<output mode>/frames:<logged frames>.
+// Each synthetic frame has N detections (spread over the classes) and N
+// tracked objects. The log is prefilled with the given number of frames
+// first, so the cost of a growing log shows up (the document mode rewrites
+// the whole file every frame). With mode:async_json the time is the cost of
+// the caller; allocations and bytes include the writer thread.
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "json_log.hpp"
+
+// === Allocation counter === //
+// Every operator new of the process (all threads) is counted
+
+static std::atomic<uint64_t> numAllocs{0};
+
+void* operator new(size_t size)
+{
+	numAllocs.fetch_add(1, std::memory_order_relaxed);
+
+	void* ptr = malloc(size > 0 ? size : 1);
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+// === Settings === //
+
+// Distinct synthetic frames, logged in turn
+#define BENCH_NUM_WORKLOADS 16
+
+#define BENCH_MAX_ITERATIONS 1000000
+
+enum BENCH_LOG_MODE
+{
+	BENCH_MODE_NONE,            // Serialization only, no log file
+	BENCH_MODE_DOCUMENT,        // Legacy single document, rewritten every frame
+	BENCH_MODE_STREAM_JSON,     // JSON Lines stream
+	BENCH_MODE_STREAM_CBOR,     // Length-prefixed CBOR stream
+	BENCH_MODE_STREAM_MSGPACK,  // Length-prefixed MessagePack stream
+	BENCH_MODE_ASYNC_JSON,      // JSON Lines stream from the writer thread
+	BENCH_NUM_MODES
+};
+
+static const char* modeNames[BENCH_NUM_MODES] =
+{
+	"none",
+	"document",
+	"stream_json",
+	"stream_cbor",
+	"stream_msgpack",
+	"async_json"
+};
+
+static const char* modeExtensions[BENCH_NUM_MODES] =
+{
+	".json",
+	".json",
+	".jsonl",
+	".cbor",
+	".msgpack",
+	".jsonl"
+};
+
+static const int objectCounts[] = {0, 10, 50, 200};
+static const int loggedFrameCounts[] = {1000, 10000, 100000};
+
+static double minTime = 0.5;
+static std::string logDir = "/tmp";
+static uint64_t maxLogBytes = 1024ULL << 20;
+
+// === Workload === //
+
+// One synthetic frame, boxes at model size like the ADAS lists
+struct Workload
+{
+	ADAS_Results adasResult;
+	std::vector<BoundingBox> bboxLists[JSON_LOG_DETECT_NUM_CLASSES];
+	std::vector<Object> trackedObjList;
+};
+
+static ADAS_Config_S* getBenchConfig()
+{
+	static ADAS_Config_S config;
+	config.modelWidth = 576;
+	config.modelHeight = 320;
+	config.frameWidth = 1920;
+	config.frameHeight = 1080;
+	return &config;
+}
+
+static void makeWorkload(int numObjects, int variant, Workload& workload)
+{
+	ADAS_Config_S* config = getBenchConfig();
+	unsigned int seed = 12345 + variant * 7919;
+	auto random = [&seed](int range)
+	{
+		seed = seed * 1103515245 + 12345;
+		return (int)((seed >> 16) % (unsigned int)range);
+	};
+
+	workload.adasResult.eventType = (variant % 8 == 0) ? ADAS_EVENT_LDW : ADAS_EVENT_NORMAL;
+	workload.adasResult.yVanish = 150 + random(20);
+	workload.adasResult.isDetectLine = true;
+	workload.adasResult.pLeftFar.x = 250 + random(10);
+	workload.adasResult.pLeftFar.y = 180 + random(10);
+	workload.adasResult.pLeftCarhood.x = 100 + random(10);
+	workload.adasResult.pLeftCarhood.y = 300 + random(10);
+	workload.adasResult.pRightFar.x = 320 + random(10);
+	workload.adasResult.pRightFar.y = 180 + random(10);
+	workload.adasResult.pRightCarhood.x = 470 + random(10);
+	workload.adasResult.pRightCarhood.y = 300 + random(10);
+
+	for (int j = 0; j < JSON_LOG_DETECT_NUM_CLASSES; j++)
+		workload.bboxLists[j].clear();
+	workload.trackedObjList.clear();
+
+	for (int i = 0; i < numObjects; i++)
+	{
+		int x1 = random(config->modelWidth - 64);
+		int y1 = random(config->modelHeight - 64);
+		int x2 = x1 + 8 + random(56);
+		int y2 = y1 + 8 + random(56);
+
+		// Detection
+		int classIdx = i % JSON_LOG_DETECT_NUM_CLASSES;
+		BoundingBox detectBox(x1, y1, x2, y2, classIdx);
+		detectBox.confidence = 0.3f + random(70) / 100.0f;
+		workload.bboxLists[classIdx].push_back(detectBox);
+
+		// Tracked object: human, rider or vehicle
+		Object trackedObj;
+		trackedObj.id = i;
+		trackedObj.distanceToCamera = 5.0f + random(600) / 10.0f;
+		trackedObj.bboxList.push_back(BoundingBox(x1, y1, x2, y2, i % 3));
+		workload.trackedObjList.push_back(trackedObj);
+	}
+}
+
+static void makeWorkloads(int numObjects, std::vector<Workload>& workloads)
+{
+	workloads.resize(BENCH_NUM_WORKLOADS);
+	for (int i = 0; i < BENCH_NUM_WORKLOADS; i++)
+		makeWorkload(numObjects, i, workloads[i]);
+}
+
+// === Log files === //
+
+static std::string getLogPath(int mode)
+{
+	return logDir + "/json_log_bench" + modeExtensions[mode];
+}
+
+static void removeLog(const std::string& path)
+{
+	unlink(path.c_str());
+	unlink((path + JSON_LOG_INDEX_SUFFIX).c_str());
+}
+
+static int64_t getFileSize(const std::string& path)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return 0;
+	return (int64_t)st.st_size;
+}
+
+// Log file and its sidecar index
+static int64_t getLogSize(const std::string& path)
+{
+	return getFileSize(path) + getFileSize(path + JSON_LOG_INDEX_SUFFIX);
+}
+
+static JSON_LOG_Config_S getLogConfig(int mode)
+{
+	JSON_LOG_Config_S logConfig;
+	logConfig.logLevel = JSON_LOG_LEVEL_NONE;
+	logConfig.saveToFile = (mode != BENCH_MODE_NONE);
+	logConfig.streamMode = (mode != BENCH_MODE_DOCUMENT);
+
+	if (mode == BENCH_MODE_STREAM_CBOR)
+		logConfig.format = JSON_LOG_FORMAT_CBOR;
+	else if (mode == BENCH_MODE_STREAM_MSGPACK)
+		logConfig.format = JSON_LOG_FORMAT_MSGPACK;
+	else
+		logConfig.format = JSON_LOG_FORMAT_JSON;
+
+	// Every record is written, so bytes/frame is not lowered by drops
+	logConfig.asyncWrite = (mode == BENCH_MODE_ASYNC_JSON);
+	logConfig.queuePolicy = JSON_LOG_QUEUE_BLOCK;
+	return logConfig;
+}
+
+// Upper bound of the log size per frame: the indented frame record
+static size_t getFrameSizeEstimate(const Workload& workload)
+{
+	JSON_LOG jsonLog(getLogPath(BENCH_MODE_NONE), getLogConfig(BENCH_MODE_NONE));
+	std::string frameString = jsonLog.JsonLogString_2(workload.adasResult, getBenchConfig(),
+													  workload.bboxLists[JSON_LOG_DETECT_HUMAN],
+													  workload.bboxLists[JSON_LOG_DETECT_SMALL_VEHICLE],
+													  workload.bboxLists[JSON_LOG_DETECT_VEHICLE],
+													  workload.bboxLists[JSON_LOG_DETECT_ROAD_SIGN],
+													  workload.bboxLists[JSON_LOG_DETECT_STOP_SIGN],
+													  workload.trackedObjList, 0);
+	return nlohmann::json::parse(frameString).dump(4).size();
+}
+
+// Legacy document {"frame_ID": {...}} of numFrames frames
+static std::string makeDocument(const std::vector<Workload>& workloads, int numFrames)
+{
+	std::vector<nlohmann::json> frames(workloads.size());
+	{
+		JSON_LOG jsonLog(getLogPath(BENCH_MODE_NONE), getLogConfig(BENCH_MODE_NONE));
+		for (int i = 0; i < workloads.size(); i++)
+		{
+			const Workload& workload = workloads[i];
+			std::string frameString = jsonLog.JsonLogString_2(workload.adasResult, getBenchConfig(),
+				workload.bboxLists[JSON_LOG_DETECT_HUMAN],
+				workload.bboxLists[JSON_LOG_DETECT_SMALL_VEHICLE],
+				workload.bboxLists[JSON_LOG_DETECT_VEHICLE],
+				workload.bboxLists[JSON_LOG_DETECT_ROAD_SIGN],
+				workload.bboxLists[JSON_LOG_DETECT_STOP_SIGN],
+				workload.trackedObjList, 0);
+			frames[i] = nlohmann::json::parse(frameString)["frame_ID"]["0"];
+		}
+	}
+
+	nlohmann::json document;
+	nlohmann::json& frameIDs = document["frame_ID"];
+	for (int i = 0; i < numFrames; i++)
+		frameIDs[std::to_string(i)] = frames[i % frames.size()];
+
+	return document.dump(4);
+}
+
+// Fresh log of the mode holding frames 0 .. numFrames-1
+static void prefillLog(int mode, const std::vector<Workload>& workloads, int numFrames)
+{
+	std::string path = getLogPath(mode);
+	removeLog(path);
+
+	if (mode == BENCH_MODE_NONE || numFrames == 0)
+		return;
+
+	if (mode == BENCH_MODE_DOCUMENT)
+	{
+		JSON_LOG jsonLog(path);
+		jsonLog.SaveJsonLogFile(makeDocument(workloads, numFrames));
+		return;
+	}
+
+	// Stream modes, written synchronously (the async log is JSON Lines too)
+	JSON_LOG jsonLog(path, getLogConfig(mode == BENCH_MODE_ASYNC_JSON ? BENCH_MODE_STREAM_JSON : mode));
+	for (int i = 0; i < numFrames; i++)
+	{
+		const Workload& workload = workloads[i % workloads.size()];
+		jsonLog.LogFrame(workload.adasResult, getBenchConfig(),
+						 workload.bboxLists[JSON_LOG_DETECT_HUMAN],
+						 workload.bboxLists[JSON_LOG_DETECT_SMALL_VEHICLE],
+						 workload.bboxLists[JSON_LOG_DETECT_VEHICLE],
+						 workload.bboxLists[JSON_LOG_DETECT_ROAD_SIGN],
+						 workload.bboxLists[JSON_LOG_DETECT_STOP_SIGN],
+						 workload.trackedObjList, i);
+	}
+}
+
+// === Runner === //
+
+struct BenchArgs
+{
+	int numObjects = 0;
+	int mode = BENCH_MODE_NONE;
+	int numLoggedFrames = 0;
+};
+
+struct BenchState
+{
+	BenchArgs args;
+	int framesPerIteration = 1;
+	uint64_t numIterations = 0;
+	double seconds = 0;
+	uint64_t allocsAtStart = 0;
+	uint64_t numAllocs = 0;
+	int64_t bytesPerFrame = -1;  // -1: nothing written
+	std::string skipReason;
+};
+
+typedef void (*BenchFunc)(BenchState& state);
+
+struct Benchmark
+{
+	std::string name;
+	BenchFunc func;
+	BenchArgs args;
+};
+
+// One untimed call first (sizes the reused buffers, opens the files), then
+// func(iteration) until minTime has passed. Allocations are counted from the
+// first timed call until finishAllocs().
+template <typename Func>
+static void runIterations(BenchState& state, Func func)
+{
+	func(0);
+
+	state.allocsAtStart = numAllocs.load(std::memory_order_relaxed);
+	auto start = std::chrono::steady_clock::now();
+
+	uint64_t n = 0;
+	double elapsed = 0;
+	while (elapsed < minTime && n < BENCH_MAX_ITERATIONS)
+	{
+		func(n + 1);
+		n++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	state.numIterations = n;
+	state.seconds = elapsed;
+}
+
+static void finishAllocs(BenchState& state)
+{
+	state.numAllocs = numAllocs.load(std::memory_order_relaxed) - state.allocsAtStart;
+}
+
+static bool checkLogSize(BenchState& state, const std::vector<Workload>& workloads)
+{
+	uint64_t logBytes = (uint64_t)getFrameSizeEstimate(workloads[0]) * state.args.numLoggedFrames;
+	if (logBytes <= maxLogBytes)
+		return true;
+
+	state.skipReason = "log of about " + std::to_string(logBytes >> 20) + " MB, see --max-log-mb";
+	return false;
+}
+
+// Bytes written per logged frame: the growth of a stream log, the whole
+// file for the document mode (rewritten every frame)
+static void setBytesPerFrame(BenchState& state, const std::string& path, int64_t sizeBefore)
+{
+	if (state.args.mode == BENCH_MODE_NONE)
+		return;
+
+	uint64_t numFramesWritten = state.numIterations + 1;
+	if (state.args.mode == BENCH_MODE_DOCUMENT)
+		state.bytesPerFrame = getFileSize(path);
+	else
+		state.bytesPerFrame = (getLogSize(path) - sizeBefore) / (int64_t)numFramesWritten;
+}
+
+// === Benchmarks === //
+
+static void BM_JsonLogString(BenchState& state)
+{
+	std::vector<Workload> workloads;
+	makeWorkloads(state.args.numObjects, workloads);
+	if (!checkLogSize(state, workloads))
+		return;
+
+	prefillLog(state.args.mode, workloads, state.args.numLoggedFrames);
+	std::string path = getLogPath(state.args.mode);
+	int64_t sizeBefore = getLogSize(path);
+
+	{
+		JSON_LOG jsonLog(path, getLogConfig(state.args.mode));
+		int frameIdx = state.args.numLoggedFrames;
+
+		runIterations(state, [&](uint64_t i)
+		{
+			const Workload& workload = workloads[i % workloads.size()];
+			const std::vector<BoundingBox>* bboxLists[JSON_LOG_DETECT_NUM_CLASSES];
+			for (int j = 0; j < JSON_LOG_DETECT_NUM_CLASSES; j++)
+				bboxLists[j] = &workload.bboxLists[j];
+
+			jsonLog.JsonLogString(workload.adasResult, getBenchConfig(), bboxLists,
+								  workload.trackedObjList, frameIdx++);
+		});
+	}
+
+	finishAllocs(state);
+	setBytesPerFrame(state, path, sizeBefore);
+	removeLog(path);
+}
+
+static void BM_JsonLogString_2(BenchState& state)
+{
+	std::vector<Workload> workloads;
+	makeWorkloads(state.args.numObjects, workloads);
+	if (!checkLogSize(state, workloads))
+		return;
+
+	prefillLog(state.args.mode, workloads, state.args.numLoggedFrames);
+	std::string path = getLogPath(state.args.mode);
+	int64_t sizeBefore = getLogSize(path);
+
+	{
+		JSON_LOG jsonLog(path, getLogConfig(state.args.mode));
+		int frameIdx = state.args.numLoggedFrames;
+
+		runIterations(state, [&](uint64_t i)
+		{
+			const Workload& workload = workloads[i % workloads.size()];
+			jsonLog.JsonLogString_2(workload.adasResult, getBenchConfig(),
+									workload.bboxLists[JSON_LOG_DETECT_HUMAN],
+									workload.bboxLists[JSON_LOG_DETECT_SMALL_VEHICLE],
+									workload.bboxLists[JSON_LOG_DETECT_VEHICLE],
+									workload.bboxLists[JSON_LOG_DETECT_ROAD_SIGN],
+									workload.bboxLists[JSON_LOG_DETECT_STOP_SIGN],
+									workload.trackedObjList, frameIdx++);
+		});
+
+		// The writer thread drains the queue here, counted as well
+	}
+
+	finishAllocs(state);
+	setBytesPerFrame(state, path, sizeBefore);
+	removeLog(path);
+}
+
+static void BM_GetJsonValueByKey(BenchState& state)
+{
+	std::vector<Workload> workloads;
+	makeWorkloads(state.args.numObjects, workloads);
+	if (!checkLogSize(state, workloads))
+		return;
+
+	prefillLog(state.args.mode, workloads, state.args.numLoggedFrames);
+	std::string path = getLogPath(state.args.mode);
+
+	{
+		JSON_LOG jsonLog(path, getLogConfig(state.args.mode));
+		unsigned int seed = 1;
+
+		runIterations(state, [&](uint64_t i)
+		{
+			seed = seed * 1103515245 + 12345;
+			int frameIdx = (int)((seed >> 8) % (unsigned int)state.args.numLoggedFrames);
+			jsonLog.GetJsonValueByKey(frameIdx);
+		});
+	}
+
+	finishAllocs(state);
+	removeLog(path);
+}
+
+static void BM_SaveJsonLogFile(BenchState& state)
+{
+	std::vector<Workload> workloads;
+	makeWorkloads(state.args.numObjects, workloads);
+	if (!checkLogSize(state, workloads))
+		return;
+
+	std::string path = getLogPath(BENCH_MODE_DOCUMENT);
+	removeLog(path);
+	std::string document = makeDocument(workloads, state.args.numLoggedFrames);
+
+	// One call writes every logged frame
+	state.framesPerIteration = state.args.numLoggedFrames;
+
+	{
+		JSON_LOG jsonLog(path);
+		runIterations(state, [&](uint64_t i)
+		{
+			jsonLog.SaveJsonLogFile(document);
+		});
+	}
+
+	finishAllocs(state);
+	state.bytesPerFrame = getFileSize(path) / state.args.numLoggedFrames;
+	removeLog(path);
+}
+
+// === Registration === //
+
+static std::string getBenchName(const char* funcName, const BenchArgs& args)
+{
+	std::string name = funcName;
+	name += "/objects:" + std::to_string(args.numObjects);
+	name += "/mode:" + std::string(modeNames[args.mode]);
+	if (args.mode != BENCH_MODE_NONE)
+		name += "/frames:" + std::to_string(args.numLoggedFrames);
+	return name;
+}
+
+static void registerBenchmarks(const char* funcName, BenchFunc func,
+							   const std::vector<int>& modes, std::vector<Benchmark>& benchmarks)
+{
+	for (int o = 0; o < sizeof(objectCounts) / sizeof(objectCounts[0]); o++)
+	{
+		for (int m = 0; m < modes.size(); m++)
+		{
+			for (int f = 0; f < sizeof(loggedFrameCounts) / sizeof(loggedFrameCounts[0]); f++)
+			{
+				BenchArgs args;
+				args.numObjects = objectCounts[o];
+				args.mode = modes[m];
+				args.numLoggedFrames = loggedFrameCounts[f];
+
+				// Nothing is logged without a file, one case is enough
+				if (args.mode == BENCH_MODE_NONE)
+				{
+					if (f > 0)
+						continue;
+					args.numLoggedFrames = 0;
+				}
+
+				Benchmark benchmark;
+				benchmark.name = getBenchName(funcName, args);
+				benchmark.func = func;
+				benchmark.args = args;
+				benchmarks.push_back(benchmark);
+			}
+		}
+	}
+}
+
+static void printResult(const Benchmark& benchmark, const BenchState& state)
+{
+	if (!state.skipReason.empty())
+	{
+		printf("%-64s skipped: %s\n", benchmark.name.c_str(), state.skipReason.c_str());
+		return;
+	}
+
+	double numFrames = (double)state.numIterations * state.framesPerIteration;
+	if (numFrames <= 0)
+		numFrames = 1;
+
+	char bytes[32] = "-";
+	if (state.bytesPerFrame >= 0)
+		snprintf(bytes, sizeof(bytes), "%lld", (long long)state.bytesPerFrame);
+
+	printf("%-64s %10llu %14.0f %14.1f %14s\n",
+		   benchmark.name.c_str(),
+		   (unsigned long long)state.numIterations,
+		   state.seconds * 1e9 / numFrames,
+		   state.numAllocs / numFrames,
+		   bytes);
+	fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			cerr << "Missing value of " << option << endl;
+			return 1;
+		}
+
+		if (option == "--filter")
+			filter = argv[++i];
+		else if (option == "--min-time")
+			minTime = atof(argv[++i]);
+		else if (option == "--dir")
+			logDir = argv[++i];
+		else if (option == "--max-log-mb")
+			maxLogBytes = (uint64_t)atoll(argv[++i]) << 20;
+		else
+		{
+			cerr << "Usage: " << argv[0]
+				 << " [--filter <substring>] [--min-time <s>] [--dir <path>] [--max-log-mb <MB>]" << endl;
+			return 1;
+		}
+	}
+
+	std::vector<int> syncModes = {BENCH_MODE_NONE, BENCH_MODE_DOCUMENT, BENCH_MODE_STREAM_JSON,
+								  BENCH_MODE_STREAM_CBOR, BENCH_MODE_STREAM_MSGPACK};
+	std::vector<int> allModes = syncModes;
+	allModes.push_back(BENCH_MODE_ASYNC_JSON);
+	std::vector<int> fileModes = {BENCH_MODE_DOCUMENT, BENCH_MODE_STREAM_JSON,
+								  BENCH_MODE_STREAM_CBOR, BENCH_MODE_STREAM_MSGPACK};
+	std::vector<int> documentMode = {BENCH_MODE_DOCUMENT};
+
+	std::vector<Benchmark> benchmarks;
+	registerBenchmarks("BM_JsonLogString", BM_JsonLogString, allModes, benchmarks);
+	registerBenchmarks("BM_JsonLogString_2", BM_JsonLogString_2, allModes, benchmarks);
+	registerBenchmarks("BM_GetJsonValueByKey", BM_GetJsonValueByKey, fileModes, benchmarks);
+	registerBenchmarks("BM_SaveJsonLogFile", BM_SaveJsonLogFile, documentMode, benchmarks);
+
+	printf("%-64s %10s %14s %14s %14s\n", "Benchmark", "Iterations", "ns/frame", "allocs/frame", "bytes/frame");
+	printf("%s\n", std::string(120, '-').c_str());
+
+	for (int i = 0; i < benchmarks.size(); i++)
+	{
+		const Benchmark& benchmark = benchmarks[i];
+		if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+			continue;
+
+		BenchState state;
+		state.args = benchmark.args;
+		benchmark.func(state);
+		printResult(benchmark, state);
+	}
+
+	return 0;
+}
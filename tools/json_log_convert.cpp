@@ -0,0 +1,36 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+// Offline converter for binary (CBOR / MessagePack) ADAS frame logs.
+//
+// Usage: json_log_convert <input.cbor|input.msgpack> <output.json> [--lines]
+//   default  : one JSON document {"frame_ID": {...}} as written by SaveJsonLogFile
+//   --lines  : JSON Lines, one frame per line as written by the stream mode
+
+#include "json_log.hpp"
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		cerr << "Usage: " << argv[0] << " <input.cbor|input.msgpack> <output.json> [--lines]" << endl;
+		return 1;
+	}
+
+	bool jsonLines = (argc > 3 && std::string(argv[3]) == "--lines");
+
+	if (!JSON_LOG::ConvertBinaryLog(argv[1], argv[2], jsonLines))
+		return 1;
+
+	return 0;
+}
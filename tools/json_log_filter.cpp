@@ -0,0 +1,41 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+// Event log triage on the device: stream a frame log (JSON document, JSON
+// Lines, CBOR or MessagePack) and print the matches as JSON Lines.
+//
+// Usage: json_log_filter <log file> <query> [--frames]
+//   query     : <section>.<field><op><value>, op is one of == != < <= > >=
+//               e.g. "ADAS.FCW==1", "trackObj.distanceToCamera<10"
+//   --frames  : print whole matching frames instead of the matching entries
+
+#include "json_log.hpp"
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		cerr << "Usage: " << argv[0] << " <log file> <query> [--frames]" << endl;
+		return 1;
+	}
+
+	bool emitFrames = (argc > 3 && std::string(argv[3]) == "--frames");
+
+	JSON_LOG jsonLog(argv[1]);
+	int numMatches = jsonLog.FilterFrames(argv[2], std::cout, emitFrames);
+	if (numMatches < 0)
+		return 1;
+
+	cerr << numMatches << " matches" << endl;
+	return 0;
+}
@@ -0,0 +1,88 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+// Offline decoder for tracked object streams (<log file>.trk).
+//
+// Usage: track_delta_convert <input.trk> <output.jsonl>
+//   One line per frame with the trackObj entries of the JSON log:
+//   {"frame_ID":{"<N>":{"trackObj":{"VEHICLE":[{...}]}}}}
+
+#include <fstream>
+#include <iostream>
+
+#include "json.hpp"
+#include "track_delta_codec.hpp"
+
+static const char* trackLabel(int label)
+{
+	if (label == 0)
+		return "HUMAN";
+	else if (label == 1)
+		return "RIDER";
+	else if (label == 2)
+		return "VEHICLE";
+	return "";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <input.trk> <output.jsonl>" << std::endl;
+		return 1;
+	}
+
+	std::ofstream outFile(argv[2]);
+	if (!outFile.is_open())
+	{
+		std::cerr << "Unable to open " << argv[2] << std::endl;
+		return 1;
+	}
+
+	int numFrames = 0;
+	bool ret = TrackDeltaDecoder::forEachFrame(argv[1], [&](const TrackDeltaFrame& frame)
+	{
+		nlohmann::json jsonData;
+		nlohmann::json& jsonFrame = jsonData["frame_ID"][std::to_string(frame.frameIdx)];
+		jsonFrame["trackObj"] = nlohmann::json::object();
+
+		for (int i = 0; i < frame.objects.size(); i++)
+		{
+			const TrackDeltaObject& obj = frame.objects[i];
+			const char* label = trackLabel(obj.label);
+
+			nlohmann::json track;
+			track["trackObj.x1"] = obj.x1;
+			track["trackObj.y1"] = obj.y1;
+			track["trackObj.x2"] = obj.x2;
+			track["trackObj.y2"] = obj.y2;
+			track["trackObj.distanceToCamera"] = obj.distance;
+			track["trackObj.bbox.label"] = label;
+			track["trackedObj.id"] = obj.id;
+			jsonFrame["trackObj"][label].push_back(track);
+		}
+
+		outFile << jsonData.dump() << "\n";
+		numFrames++;
+		return true;
+	});
+
+	if (!ret)
+	{
+		std::cerr << "Unable to read the track stream " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::cout << "Decoded " << numFrames << " frames" << std::endl;
+	return 0;
+}
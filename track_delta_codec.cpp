@@ -0,0 +1,471 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "track_delta_codec.hpp"
+
+// ============================================
+//                   Varints
+// ============================================
+static void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+// Small magnitudes of either sign take one byte: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+static void putZigzag(std::vector<uint8_t>& out, int64_t value)
+{
+	putVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static bool getVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (pos >= size)
+			return false;
+
+		uint8_t byte = data[pos++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool getZigzag(const uint8_t* data, size_t size, size_t& pos, int& value)
+{
+	uint64_t raw;
+	if (!getVarint(data, size, pos, raw))
+		return false;
+
+	value = (int)(int64_t)((raw >> 1) ^ (~(raw & 1) + 1));
+	return true;
+}
+
+// ============================================
+//                   Objects
+// ============================================
+static bool isKeyLess(const TrackDeltaObject& a, const TrackDeltaObject& b)
+{
+	return a.label < b.label || (a.label == b.label && a.id < b.id);
+}
+
+static bool isKeyEqual(const TrackDeltaObject& a, const TrackDeltaObject& b)
+{
+	return a.label == b.label && a.id == b.id;
+}
+
+static void putKey(std::vector<uint8_t>& out, const TrackDeltaObject& obj)
+{
+	putZigzag(out, obj.label);
+	putZigzag(out, obj.id);
+}
+
+static bool getKey(const uint8_t* data, size_t size, size_t& pos, TrackDeltaObject& obj)
+{
+	return getZigzag(data, size, pos, obj.label)
+		&& getZigzag(data, size, pos, obj.id);
+}
+
+static void putObject(std::vector<uint8_t>& out, const TrackDeltaObject& obj)
+{
+	putKey(out, obj);
+	putZigzag(out, obj.x1);
+	putZigzag(out, obj.y1);
+	putZigzag(out, (int64_t)obj.x2 - obj.x1);
+	putZigzag(out, (int64_t)obj.y2 - obj.y1);
+	putZigzag(out, obj.distance);
+}
+
+static bool getObject(const uint8_t* data, size_t size, size_t& pos, TrackDeltaObject& obj)
+{
+	int width, height;
+	if (!getKey(data, size, pos, obj)
+		|| !getZigzag(data, size, pos, obj.x1)
+		|| !getZigzag(data, size, pos, obj.y1)
+		|| !getZigzag(data, size, pos, width)
+		|| !getZigzag(data, size, pos, height)
+		|| !getZigzag(data, size, pos, obj.distance))
+		return false;
+
+	obj.x2 = obj.x1 + width;
+	obj.y2 = obj.y1 + height;
+	return true;
+}
+
+// Every count is followed by at least one byte per entry
+static bool getCount(const uint8_t* data, size_t size, size_t& pos, int& count)
+{
+	uint64_t value;
+	if (!getVarint(data, size, pos, value) || value > size - pos)
+		return false;
+
+	count = (int)value;
+	return true;
+}
+
+// ============================================
+//                   Encoder
+// ============================================
+TrackDeltaEncoder::TrackDeltaEncoder(int keyframeInterval, int quantStep)
+	: m_keyframeInterval(std::max(1, keyframeInterval)),
+	  m_quantStep(std::min(std::max(1, quantStep), 255))
+{
+}
+
+void TrackDeltaEncoder::writeHeader(std::vector<uint8_t>& out) const
+{
+	uint8_t header[TRACK_DELTA_HEADER_SIZE] = {0};
+	memcpy(header, TRACK_DELTA_MAGIC, 4);
+	header[4] = TRACK_DELTA_VERSION;
+	header[5] = (uint8_t)m_quantStep;
+	out.insert(out.end(), header, header + TRACK_DELTA_HEADER_SIZE);
+}
+
+bool TrackDeltaEncoder::encodeFrame(const TrackDeltaFrame& frame, std::vector<uint8_t>& out)
+{
+	_quantize(frame, m_currObjects);
+
+	// Deltas need unique keys on both sides
+	bool hasDuplicates = false;
+	for (int i = 1; i < m_currObjects.size() && !hasDuplicates; i++)
+		hasDuplicates = isKeyEqual(m_currObjects[i - 1], m_currObjects[i]);
+
+	bool isKeyframe = (m_numDeltaFrames < 0
+					   || m_numDeltaFrames + 1 >= m_keyframeInterval
+					   || hasDuplicates
+					   || m_prevHasDuplicates);
+
+	m_payload.clear();
+
+	if (isKeyframe)
+	{
+		putVarint(m_payload, TRACK_DELTA_KEYFRAME);
+		putZigzag(m_payload, frame.frameIdx);
+		putVarint(m_payload, m_currObjects.size());
+		for (int i = 0; i < m_currObjects.size(); i++)
+			putObject(m_payload, m_currObjects[i]);
+
+		m_numDeltaFrames = 0;
+	}
+	else
+	{
+		// Both lists are sorted by key, one merge pass sorts the objects out
+		m_deaths.clear();
+		m_births.clear();
+		m_updates.clear();
+
+		int p = 0;
+		int c = 0;
+		while (p < m_prevObjects.size() || c < m_currObjects.size())
+		{
+			if (c == m_currObjects.size()
+				|| (p < m_prevObjects.size() && isKeyLess(m_prevObjects[p], m_currObjects[c])))
+			{
+				m_deaths.push_back(p++);
+			}
+			else if (p == m_prevObjects.size() || isKeyLess(m_currObjects[c], m_prevObjects[p]))
+			{
+				m_births.push_back(c++);
+			}
+			else
+			{
+				m_updates.push_back(std::make_pair(p++, c++));
+			}
+		}
+
+		putVarint(m_payload, TRACK_DELTA_DELTA);
+		putZigzag(m_payload, (int64_t)frame.frameIdx - m_prevFrameIdx);
+
+		putVarint(m_payload, m_deaths.size());
+		for (int i = 0; i < m_deaths.size(); i++)
+			putKey(m_payload, m_prevObjects[m_deaths[i]]);
+
+		putVarint(m_payload, m_births.size());
+		for (int i = 0; i < m_births.size(); i++)
+			putObject(m_payload, m_currObjects[m_births[i]]);
+
+		// Count goes first, so unchanged objects are skipped in a second pass
+		int numChanged = 0;
+		for (int i = 0; i < m_updates.size(); i++)
+		{
+			const TrackDeltaObject& prev = m_prevObjects[m_updates[i].first];
+			const TrackDeltaObject& curr = m_currObjects[m_updates[i].second];
+			if (prev.x1 != curr.x1 || prev.y1 != curr.y1 || prev.x2 != curr.x2
+				|| prev.y2 != curr.y2 || prev.distance != curr.distance)
+				numChanged++;
+		}
+
+		putVarint(m_payload, numChanged);
+		for (int i = 0; i < m_updates.size(); i++)
+		{
+			const TrackDeltaObject& prev = m_prevObjects[m_updates[i].first];
+			const TrackDeltaObject& curr = m_currObjects[m_updates[i].second];
+
+			int mask = 0;
+			if (curr.x1 != prev.x1)
+				mask |= TRACK_DELTA_FIELD_X1;
+			if (curr.y1 != prev.y1)
+				mask |= TRACK_DELTA_FIELD_Y1;
+			if (curr.x2 != prev.x2)
+				mask |= TRACK_DELTA_FIELD_X2;
+			if (curr.y2 != prev.y2)
+				mask |= TRACK_DELTA_FIELD_Y2;
+			if (curr.distance != prev.distance)
+				mask |= TRACK_DELTA_FIELD_DISTANCE;
+			if (mask == 0)
+				continue;
+
+			putKey(m_payload, curr);
+			putVarint(m_payload, mask);
+			if (mask & TRACK_DELTA_FIELD_X1)
+				putZigzag(m_payload, (int64_t)curr.x1 - prev.x1);
+			if (mask & TRACK_DELTA_FIELD_Y1)
+				putZigzag(m_payload, (int64_t)curr.y1 - prev.y1);
+			if (mask & TRACK_DELTA_FIELD_X2)
+				putZigzag(m_payload, (int64_t)curr.x2 - prev.x2);
+			if (mask & TRACK_DELTA_FIELD_Y2)
+				putZigzag(m_payload, (int64_t)curr.y2 - prev.y2);
+			if (mask & TRACK_DELTA_FIELD_DISTANCE)
+				putZigzag(m_payload, (int64_t)curr.distance - prev.distance);
+		}
+
+		m_numDeltaFrames++;
+	}
+
+	putVarint(out, m_payload.size());
+	out.insert(out.end(), m_payload.begin(), m_payload.end());
+
+	m_prevObjects.swap(m_currObjects);
+	m_prevFrameIdx = frame.frameIdx;
+	m_prevHasDuplicates = hasDuplicates;
+	return isKeyframe;
+}
+
+void TrackDeltaEncoder::reset()
+{
+	m_numDeltaFrames = -1;
+	m_prevObjects.clear();
+}
+
+void TrackDeltaEncoder::_quantize(const TrackDeltaFrame& frame, std::vector<TrackDeltaObject>& objects) const
+{
+	objects.assign(frame.objects.begin(), frame.objects.end());
+
+	if (m_quantStep > 1)
+	{
+		// Round to the nearest step, negative values too
+		auto quantize = [this](int value)
+		{
+			int half = m_quantStep / 2;
+			return value >= 0 ? (value + half) / m_quantStep : -((-value + half) / m_quantStep);
+		};
+
+		for (int i = 0; i < objects.size(); i++)
+		{
+			TrackDeltaObject& obj = objects[i];
+			obj.x1 = quantize(obj.x1);
+			obj.y1 = quantize(obj.y1);
+			obj.x2 = quantize(obj.x2);
+			obj.y2 = quantize(obj.y2);
+		}
+	}
+
+	std::sort(objects.begin(), objects.end(), isKeyLess);
+}
+
+// ============================================
+//                   Decoder
+// ============================================
+bool TrackDeltaDecoder::readHeader(const uint8_t* data, size_t size)
+{
+	if (size < TRACK_DELTA_HEADER_SIZE
+		|| memcmp(data, TRACK_DELTA_MAGIC, 4) != 0
+		|| data[4] != TRACK_DELTA_VERSION
+		|| data[5] == 0)
+		return false;
+
+	m_quantStep = data[5];
+	reset();
+	return true;
+}
+
+bool TrackDeltaDecoder::decodeFrame(const uint8_t* data, size_t size, size_t& pos, TrackDeltaFrame& frame)
+{
+	uint64_t length;
+	if (!getVarint(data, size, pos, length) || length > size - pos)
+		return false;
+
+	// Parse within the record only, pos moves past it even if it is corrupt
+	const uint8_t* record = data + pos;
+	size_t recordSize = (size_t)length;
+	size_t p = 0;
+	pos += recordSize;
+
+	uint64_t type;
+	int frameIdx;
+	if (!getVarint(record, recordSize, p, type) || !getZigzag(record, recordSize, p, frameIdx))
+		return false;
+
+	int count;
+	if (type == TRACK_DELTA_KEYFRAME)
+	{
+		if (!getCount(record, recordSize, p, count))
+			return false;
+
+		m_nextObjects.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			if (!getObject(record, recordSize, p, m_nextObjects[i]))
+				return false;
+		}
+		std::sort(m_nextObjects.begin(), m_nextObjects.end(), isKeyLess);
+	}
+	else if (type == TRACK_DELTA_DELTA)
+	{
+		if (!m_hasKeyframe)
+			return false;
+
+		frameIdx += m_prevFrameIdx;
+
+		// Objects gone, in key order
+		if (!getCount(record, recordSize, p, count))
+			return false;
+
+		m_deaths.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			if (!getKey(record, recordSize, p, m_deaths[i]))
+				return false;
+		}
+
+		m_nextObjects.clear();
+		for (int i = 0; i < m_objects.size(); i++)
+		{
+			if (!std::binary_search(m_deaths.begin(), m_deaths.end(), m_objects[i], isKeyLess))
+				m_nextObjects.push_back(m_objects[i]);
+		}
+
+		// Objects new in this frame
+		if (!getCount(record, recordSize, p, count))
+			return false;
+
+		size_t numKept = m_nextObjects.size();
+		for (int i = 0; i < count; i++)
+		{
+			TrackDeltaObject obj;
+			if (!getObject(record, recordSize, p, obj))
+				return false;
+			m_nextObjects.push_back(obj);
+		}
+		std::inplace_merge(m_nextObjects.begin(), m_nextObjects.begin() + numKept,
+						   m_nextObjects.end(), isKeyLess);
+
+		// Changed fields of the remaining objects
+		if (!getCount(record, recordSize, p, count))
+			return false;
+
+		for (int i = 0; i < count; i++)
+		{
+			TrackDeltaObject key;
+			uint64_t mask;
+			if (!getKey(record, recordSize, p, key) || !getVarint(record, recordSize, p, mask))
+				return false;
+
+			auto it = std::lower_bound(m_nextObjects.begin(), m_nextObjects.end(), key, isKeyLess);
+			if (it == m_nextObjects.end() || !isKeyEqual(*it, key))
+				return false;
+
+			int change;
+			int* fields[] = {&it->x1, &it->y1, &it->x2, &it->y2, &it->distance};
+			for (int j = 0; j < 5; j++)
+			{
+				if (!(mask & (1 << j)))
+					continue;
+				if (!getZigzag(record, recordSize, p, change))
+					return false;
+				*fields[j] += change;
+			}
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	m_objects.swap(m_nextObjects);
+	m_prevFrameIdx = frameIdx;
+	m_hasKeyframe = true;
+
+	// Back to pixels
+	frame.frameIdx = frameIdx;
+	frame.objects.assign(m_objects.begin(), m_objects.end());
+	for (int i = 0; i < frame.objects.size(); i++)
+	{
+		TrackDeltaObject& obj = frame.objects[i];
+		obj.x1 *= m_quantStep;
+		obj.y1 *= m_quantStep;
+		obj.x2 *= m_quantStep;
+		obj.y2 *= m_quantStep;
+	}
+	return true;
+}
+
+void TrackDeltaDecoder::reset()
+{
+	m_hasKeyframe = false;
+	m_prevFrameIdx = 0;
+	m_objects.clear();
+}
+
+bool TrackDeltaDecoder::forEachFrame(const std::string& path,
+									 const std::function<bool(const TrackDeltaFrame& frame)>& callback)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	TrackDeltaDecoder decoder;
+	if (!decoder.readHeader(data.data(), data.size()))
+		return false;
+
+	TrackDeltaFrame frame;
+	size_t pos = TRACK_DELTA_HEADER_SIZE;
+	while (pos < data.size())
+	{
+		// A corrupt record costs the frames until the next keyframe
+		if (!decoder.decodeFrame(data.data(), data.size(), pos, frame))
+		{
+			decoder.reset();
+			continue;
+		}
+
+		if (!callback(frame))
+			break;
+	}
+
+	return true;
+}
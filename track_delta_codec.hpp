@@ -0,0 +1,145 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __TRACK_DELTA_CODEC__
+#define __TRACK_DELTA_CODEC__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Stream layout: 8 byte header ("TRKD", version, quantization step, 2 reserved)
+// followed by records of [varint length][payload], one per frame
+#define TRACK_DELTA_MAGIC "TRKD"
+#define TRACK_DELTA_VERSION 1
+#define TRACK_DELTA_HEADER_SIZE 8
+
+// Frames between keyframes, decoding can start at any keyframe
+#define TRACK_DELTA_DEFAULT_KEYFRAME_INTERVAL 30
+
+// Record payload:
+//   varint type, zigzag frame index (keyframe) or frame index step (delta)
+//   keyframe : varint count, full objects
+//   delta    : varint count, keys of the objects gone
+//              varint count, full objects new in this frame
+//              varint count, updates {key, varint field mask, zigzag change per field}
+// key = zigzag label, zigzag id; full object = key, zigzag x1, y1, width, height, distance.
+// Coordinates are in units of the quantization step.
+enum TRACK_DELTA_RECORD_TYPE
+{
+	TRACK_DELTA_KEYFRAME = 0,
+	TRACK_DELTA_DELTA = 1
+};
+
+// Field mask bits of an update
+enum TRACK_DELTA_FIELD
+{
+	TRACK_DELTA_FIELD_X1 = 1 << 0,
+	TRACK_DELTA_FIELD_Y1 = 1 << 1,
+	TRACK_DELTA_FIELD_X2 = 1 << 2,
+	TRACK_DELTA_FIELD_Y2 = 1 << 3,
+	TRACK_DELTA_FIELD_DISTANCE = 1 << 4
+};
+
+// A tracked object is identified by (label, id), ids of the per-class
+// trackers overlap
+struct TrackDeltaObject
+{
+	int label = -1;
+	int id = 0;
+	int x1 = 0;
+	int y1 = 0;
+	int x2 = 0;
+	int y2 = 0;
+	int distance = 0;  // Distance to camera, whole meters as logged
+};
+
+struct TrackDeltaFrame
+{
+	int frameIdx = 0;
+	std::vector<TrackDeltaObject> objects;  // Sorted by (label, id) when decoded
+};
+
+// Encodes the tracked objects of consecutive frames: a keyframe every
+// keyframeInterval frames, in between only the objects that appeared,
+// disappeared or moved. Coordinates are quantized to quantStep pixels, the
+// deltas are taken between quantized values so errors never accumulate.
+class TrackDeltaEncoder
+{
+public:
+	explicit TrackDeltaEncoder(int keyframeInterval = TRACK_DELTA_DEFAULT_KEYFRAME_INTERVAL,
+							   int quantStep = 1);
+
+	// Stream header, written once before the first record
+	void writeHeader(std::vector<uint8_t>& out) const;
+
+	// Append the record of the frame to out, returns true for a keyframe
+	bool encodeFrame(const TrackDeltaFrame& frame, std::vector<uint8_t>& out);
+
+	// Next frame is a keyframe
+	void reset();
+
+	int getQuantStep() const { return m_quantStep; }
+
+private:
+	void _quantize(const TrackDeltaFrame& frame, std::vector<TrackDeltaObject>& objects) const;
+
+	int m_keyframeInterval;
+	int m_quantStep;
+	int m_numDeltaFrames = -1;  // Since the last keyframe, -1: no keyframe yet
+	int m_prevFrameIdx = 0;
+	bool m_prevHasDuplicates = false;
+
+	// Reused every frame
+	std::vector<TrackDeltaObject> m_prevObjects;  // Quantized, sorted by key
+	std::vector<TrackDeltaObject> m_currObjects;
+	std::vector<int> m_deaths;                    // Indices into m_prevObjects
+	std::vector<int> m_births;                    // Indices into m_currObjects
+	std::vector<std::pair<int, int>> m_updates;   // (prev, curr) indices
+	std::vector<uint8_t> m_payload;
+};
+
+// Rebuilds full frames from the records of a TrackDeltaEncoder stream
+class TrackDeltaDecoder
+{
+public:
+	// Parse the stream header, returns false if it is not one
+	bool readHeader(const uint8_t* data, size_t size);
+
+	// Decode the record at data[pos] and move pos past it. Returns false for
+	// a truncated or corrupt record, or a delta before the first keyframe.
+	bool decodeFrame(const uint8_t* data, size_t size, size_t& pos, TrackDeltaFrame& frame);
+
+	// Forget the objects, wait for the next keyframe
+	void reset();
+
+	int getQuantStep() const { return m_quantStep; }
+
+	// Offline: decode every frame of a .trk file, return false from the
+	// callback to stop
+	static bool forEachFrame(const std::string& path,
+							 const std::function<bool(const TrackDeltaFrame& frame)>& callback);
+
+private:
+	int m_quantStep = 1;
+	bool m_hasKeyframe = false;
+	int m_prevFrameIdx = 0;
+
+	std::vector<TrackDeltaObject> m_objects;  // Quantized, sorted by key
+	std::vector<TrackDeltaObject> m_nextObjects;
+	std::vector<TrackDeltaObject> m_deaths;
+};
+
+#endif
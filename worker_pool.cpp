@@ -0,0 +1,85 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#include "worker_pool.hpp"
+
+WorkerPool::WorkerPool(int numThreads)
+{
+	for (int i = 0; i < numThreads; i++)
+		m_threads.emplace_back(&WorkerPool::_runWorkerFunc, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopped = true;
+	}
+	m_condition.notify_all();
+
+	for (int i = 0; i < m_threads.size(); i++)
+	{
+		if (m_threads[i].joinable())
+			m_threads[i].join();
+	}
+}
+
+void WorkerPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_condition.notify_all();
+}
+
+void WorkerPool::waitUntil(const std::function<bool()>& isDone)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!isDone())
+	{
+		if (!m_tasks.empty())
+			_runTask(lock);
+		else
+			m_condition.wait(lock);
+	}
+}
+
+void WorkerPool::_runWorkerFunc()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_condition.wait(lock, [this] { return m_isStopped || !m_tasks.empty(); });
+		if (m_tasks.empty())
+			break;  // Stopped, queue drained
+
+		_runTask(lock);
+	}
+}
+
+// Called with the lock held, runs one task without it
+void WorkerPool::_runTask(std::unique_lock<std::mutex>& lock)
+{
+	std::function<void()> task = std::move(m_tasks.front());
+	m_tasks.pop_front();
+
+	lock.unlock();
+	task();
+	lock.lock();
+
+	// Waiters re-check their condition
+	m_condition.notify_all();
+}
@@ -0,0 +1,58 @@
+/*
+  (C) 2023-2024 Wistron NeWeb Corporation (WNC) - All Rights Reserved
+
+  This software and its associated documentation are the confidential and
+  proprietary information of Wistron NeWeb Corporation (WNC) ("Company") and
+  may not be copied, modified, distributed, or otherwise disclosed to third
+  parties without the express written consent of the Company.
+
+  Unauthorized reproduction, distribution, or disclosure of this software and
+  its associated documentation or the information contained herein is a
+  violation of applicable laws and may result in severe legal penalties.
+*/
+
+#ifndef __WORKER_POOL__
+#define __WORKER_POOL__
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+// Fixed set of worker threads sharing one FIFO task queue.
+//
+// A thread waiting for its tasks (waitUntil) runs queued tasks itself instead
+// of sleeping, so a task may submit and wait for sub-tasks without deadlock,
+// and a pool of 0 threads runs everything on the waiting thread, in
+// submission order.
+class WorkerPool
+{
+public:
+	explicit WorkerPool(int numThreads);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void submit(std::function<void()> task);
+
+	// Help with queued tasks until isDone() returns true. isDone() is
+	// checked under the pool lock after every finished task.
+	void waitUntil(const std::function<bool()>& isDone);
+
+	int getNumThreads() const { return (int)m_threads.size(); }
+
+private:
+	void _runWorkerFunc();
+	void _runTask(std::unique_lock<std::mutex>& lock);
+
+	std::vector<std::thread> m_threads;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_isStopped = false;
+};
+
+#endif